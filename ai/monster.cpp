@@ -27,7 +27,6 @@
 #include "game/defs.h"
 
 #include <map>
-#include <cmath>
 
 #include <boost/foreach.hpp>
 
@@ -67,6 +66,13 @@ const FSMTransition s_monsterFSMTransitions[] = {
 	{ kMonsterAttack, kPlayerTriggerDist0, kMonsterIdle   }
 };
 
+enum {
+	/**
+	 * How many actions ahead monsters plan their paths.
+	 */
+	kPathWindow = 8
+};
+
 FSM::FSM *createMonsterFSM() {
 	typedef std::map<kMonsterFSMStateID, FSM::State *> StateMap;
 	StateMap states;
@@ -91,7 +97,9 @@ FSM::FSM *createMonsterFSM() {
 
 } // end of anonymous namespace
 
-Monster::Monster(const Game::Level &parent, Game::EventDispatcher &disp) : _level(parent), _eventDisp(disp), _fsm(0), _monsters(), _player(0) {
+Monster::Monster(const Game::Level &parent, Game::EventDispatcher &disp, const Base::RNG &rng)
+    : _level(parent), _eventDisp(disp), _rng(rng), _fsm(0), _reservations(parent.getMap().getWidth()),
+      _pathFinder(parent, _reservations, kPathWindow), _monsters(), _player(0) {
 	_fsm = createMonsterFSM();
 }
 
@@ -106,6 +114,7 @@ void Monster::addMonster(const Game::MonsterID monster, const Game::Monster *mon
 }
 
 void Monster::removeMonster(const Game::MonsterID monster) {
+	_reservations.release(monster);
 	_monsters.erase(monster);
 }
 
@@ -117,7 +126,7 @@ void Monster::update() {
 		// TODO: Proper implementation of this :-D
 		switch (i.second._fsmState) {
 		case kMonsterIdle: {
-			Base::Point newPos = i.second._monster->getPos() + Game::getDirection(static_cast<unsigned char>(Base::rollDice(9)));
+			Base::Point newPos = i.second._monster->getPos() + Game::getDirection(static_cast<unsigned char>(_rng.rollDice(9)));
 
 			bool didAction = false;
 			if (newPos != i.second._monster->getPos()) {
@@ -138,27 +147,10 @@ void Monster::update() {
 			} break;
 
 		case kMonsterWary:
-			if (_player) {
-				int xDist = _player->getX() - i.second._monster->getX();
-				int yDist = _player->getY() - i.second._monster->getY();
-
-				int xAdd = (xDist < 0) ? -1 : ((xDist > 0) ? +1 : 0);
-				int yAdd = (yDist < 0) ? -1 : ((yDist > 0) ? +1 : 0);
-
-				Base::Point newPos = i.second._monster->getPos();
-				newPos._x += xAdd;
-				newPos._y += yAdd;
-
-				if (_level.isWalkable(newPos)) {
-					const Game::TileDefinition &def = _level.getMap().tileDefinition(newPos);
-					if (!def.getIsLiquid())
-						_eventDisp.dispatch(new Game::MoveEvent(i.first, i.second._monster->getPos(), newPos));
-				} else {
-					_eventDisp.dispatch(new Game::IdleEvent(i.first, Game::IdleEvent::kWary));
-				}
-			} else {
+			if (_player)
+				approachPlayer(i.first, i.second);
+			else
 				_eventDisp.dispatch(new Game::IdleEvent(i.first, Game::IdleEvent::kWary));
-			}
 			break;
 
 		case kMonsterAttack:
@@ -172,39 +164,121 @@ void Monster::update() {
 	}
 }
 
+void Monster::syncState(Base::Serializer &s) {
+	_rng.syncState(s);
+
+	unsigned int count = static_cast<unsigned int>(_monsters.size());
+	s.syncCount(count);
+	if (count != _monsters.size())
+		throw Base::Serializer::Exception("AI state does not match the monsters");
+
+	BOOST_FOREACH(MonsterMap::value_type &i, _monsters) {
+		s.syncUint(i.second._fsmState);
+		if (i.second._fsmState > kMonsterAttack)
+			throw Base::Serializer::Exception("Invalid AI state");
+
+		s.syncPoints(i.second._path);
+		s.syncPoint(i.second._pathGoal);
+		s.syncUint(i.second._pathSteps);
+	}
+
+	_reservations.syncState(s);
+}
+
+void Monster::approachPlayer(const Game::MonsterID monster, MonsterState &state) {
+	const Base::Point &goal = _player->getPos();
+	const Game::TickCount curTick = _level.getCurrentTick();
+
+	// In case the player can not be reached at all, there is
+	// nothing left to do but to wait for the player to come closer.
+	if (!_level.getMap().isReachable(state._monster->getPos(), goal)) {
+		clearPath(monster, state);
+		_eventDisp.dispatch(new Game::IdleEvent(monster, Game::IdleEvent::kWaiting));
+		return;
+	}
+
+	// Only replan in case the player moved, the path is used up or
+	// the monster followed half of its window. The latter assures the
+	// reservations always reach some actions into the future.
+	if (state._path.empty() || state._pathGoal != goal || state._pathSteps >= kPathWindow / 2) {
+		state._pathGoal = goal;
+		state._pathSteps = 0;
+		_pathFinder.findPath(monster, goal, curTick, state._path);
+	}
+
+	if (state._path.empty()) {
+		_eventDisp.dispatch(new Game::IdleEvent(monster, Game::IdleEvent::kWary));
+		return;
+	}
+
+	const Base::Point curPos = state._monster->getPos();
+	Base::Point newPos = state._path.front();
+
+	// Something not taking part in the planning (like the player)
+	// might have blocked the path. Try to plan around it once.
+	if (newPos != curPos && !_level.isWalkable(newPos)) {
+		state._pathSteps = 0;
+		if (!_pathFinder.findPath(monster, goal, curTick, state._path) || state._path.empty()) {
+			clearPath(monster, state);
+			_eventDisp.dispatch(new Game::IdleEvent(monster, Game::IdleEvent::kWaiting));
+			return;
+		}
+
+		newPos = state._path.front();
+	}
+
+	state._path.pop_front();
+	++state._pathSteps;
+
+	if (newPos == curPos)
+		_eventDisp.dispatch(new Game::IdleEvent(monster, Game::IdleEvent::kWaiting));
+	else
+		_eventDisp.dispatch(new Game::MoveEvent(monster, curPos, newPos));
+}
+
+void Monster::clearPath(const Game::MonsterID monster, MonsterState &state) {
+	state._path.clear();
+	state._pathSteps = 0;
+	_reservations.release(monster);
+}
+
 void Monster::processMoveEvent(const Game::MoveEvent &event) throw () {
 	if (event.getMonster() == Game::kPlayerMonsterID) {
 		BOOST_FOREACH(MonsterMap::value_type &i, _monsters) {
 			_fsm->setState(i.second._fsmState);
 
 			// Calculate distance
-			const double dist = event.getNewPos().distanceTo(i.second._monster->getPos());
+			const int dist = event.getNewPos().distanceSquaredTo(i.second._monster->getPos());
 
-			if (dist <= std::sqrt(2))
+			if (dist <= 2)
 				_fsm->process(kPlayerTriggerDist2);
-			else if (dist <= 4.0f)
+			else if (dist <= 4 * 4)
 				_fsm->process(kPlayerTriggerDist1);
 			else
 				_fsm->process(kPlayerTriggerDist0);
 
 			i.second._fsmState = _fsm->getState();
+			if (i.second._fsmState != kMonsterWary)
+				clearPath(i.first, i.second);
 		}
 	} else if (_player) {
 		MonsterMap::iterator i = _monsters.find(event.getMonster());
 		if (i != _monsters.end()) {
 			// Calculate distance
-			const double dist = event.getNewPos().distanceTo(_player->getPos());
+			const int dist = event.getNewPos().distanceSquaredTo(_player->getPos());
 
 			_fsm->setState(i->second._fsmState);
 
-			if (dist <= std::sqrt(2))
+			if (dist <= 2)
 				_fsm->process(kPlayerTriggerDist2);
-			else if (dist <= 4.0f)
+			else if (dist <= 4 * 4)
 				_fsm->process(kPlayerTriggerDist1);
 			else
 				_fsm->process(kPlayerTriggerDist0);
 
 			i->second._fsmState = _fsm->getState();
+			if (i->second._fsmState != kMonsterWary)
+				clearPath(i->first, i->second);
 		}
 	}
 }
@@ -223,6 +297,8 @@ void Monster::processAttackEvent(const Game::AttackEvent &event) throw () {
 		_fsm->setState(i->second._fsmState);
 		_fsm->process(kPlayerAttack);
 		i->second._fsmState = _fsm->getState();
+		if (i->second._fsmState != kMonsterWary)
+			clearPath(i->first, i->second);
 	}
 }
 
@@ -22,10 +22,13 @@
 #define AI_MONSTER_H
 
 #include "fsm.h"
+#include "pathfinder.h"
 #include "game/level.h"
 #include "game/monster.h"
 #include "game/event.h"
 
+#include "base/rnd.h"
+
 #include <map>
 #include <list>
 
@@ -41,8 +44,9 @@ public:
 	 *
 	 * @param parent Level in which all monsters are placed.
 	 * @param disp Dispatcher to use for dispatching game events.
+	 * @param rng Random number generator for the AI's decisions.
 	 */
-	Monster(const Game::Level &parent, Game::EventDispatcher &disp);
+	Monster(const Game::Level &parent, Game::EventDispatcher &disp, const Base::RNG &rng);
 	~Monster();
 
 	/**
@@ -72,6 +76,14 @@ public:
 	 */
 	void update();
 
+	/**
+	 * Saves or restores the AI state of all monsters. When
+	 * restoring, all monsters must have been added already.
+	 *
+	 * @param s Serializer to use.
+	 */
+	void syncState(Base::Serializer &s);
+
 	void processMoveEvent(const Game::MoveEvent &event) throw();
 	void processIdleEvent(const Game::IdleEvent &event) throw();
 	void processDeathEvent(const Game::DeathEvent &event) throw();
@@ -90,11 +102,27 @@ private:
 	 */
 	Game::EventDispatcher &_eventDisp;
 
+	/**
+	 * The random number generator for all decisions.
+	 */
+	Base::RNG _rng;
+
 	/**
 	 * The FSM to use for internal use.
 	 */
 	FSM::FSM *_fsm;
 
+	/**
+	 * The space-time reservations of all monsters
+	 * approaching the player.
+	 */
+	ReservationTable _reservations;
+
+	/**
+	 * The path finder used for approaching the player.
+	 */
+	CooperativePathFinder _pathFinder;
+
 	/**
 	 * The AI state of a monster.
 	 */
@@ -110,8 +138,24 @@ private:
 		 */
 		const Game::Monster *_monster;
 
-		MonsterState() : _fsmState(FSM::kInvalidStateID), _monster(0) {}
-		MonsterState(FSM::StateID f, const Game::Monster *m) : _fsmState(f), _monster(m) {}
+		/**
+		 * The path the monster currently follows.
+		 */
+		Path _path;
+
+		/**
+		 * The goal the path was planned for.
+		 */
+		Base::Point _pathGoal;
+
+		/**
+		 * How many steps of the path have been taken
+		 * since it was planned.
+		 */
+		unsigned int _pathSteps;
+
+		MonsterState() : _fsmState(FSM::kInvalidStateID), _monster(0), _path(), _pathGoal(), _pathSteps(0) {}
+		MonsterState(FSM::StateID f, const Game::Monster *m) : _fsmState(f), _monster(m), _path(), _pathGoal(), _pathSteps(0) {}
 	};
 
 	/**
@@ -124,6 +168,23 @@ private:
 	 */
 	MonsterMap _monsters;
 
+	/**
+	 * Lets the monster approach the player along
+	 * its planned path.
+	 *
+	 * @param monster ID of the monster.
+	 * @param state AI state of the monster.
+	 */
+	void approachPlayer(const Game::MonsterID monster, MonsterState &state);
+
+	/**
+	 * Drops the monster's path and all its reservations.
+	 *
+	 * @param monster ID of the monster.
+	 * @param state AI state of the monster.
+	 */
+	void clearPath(const Game::MonsterID monster, MonsterState &state);
+
 	/**
 	 * A pointer to the player monster. This might
 	 * be NULl to indicate that the player monster
@@ -0,0 +1,312 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "pathfinder.h"
+
+#include <cassert>
+#include <queue>
+#include <set>
+
+#include <boost/foreach.hpp>
+
+namespace AI {
+
+bool ReservationTable::isReserved(const Base::Point &p, Game::TickCount from, Game::TickCount to, Game::MonsterID self) const {
+	const Key first = makeKey(p, from), last = makeKey(p, to);
+	ReservationMap::const_iterator i = _reservations.lower_bound(first);
+
+	// Reservations of a cell never overlap, thus only the reservation
+	// right before the range can reach into it.
+	if (i != _reservations.begin()) {
+		ReservationMap::const_iterator prev = i;
+		--prev;
+		if ((prev->first >> 32) == (first >> 32) && prev->second._end > from && prev->second._monster != self)
+			return true;
+	}
+
+	for (; i != _reservations.end() && i->first < last; ++i) {
+		if (i->second._monster != self)
+			return true;
+	}
+
+	return false;
+}
+
+void ReservationTable::reserve(const Base::Point &p, Game::TickCount from, Game::TickCount to, Game::MonsterID monster) {
+	const Key key = makeKey(p, from);
+	_reservations[key] = Reservation(to, monster);
+	_owners[monster].push_back(key);
+}
+
+void ReservationTable::release(Game::MonsterID monster) {
+	OwnerMap::iterator i = _owners.find(monster);
+	if (i == _owners.end())
+		return;
+
+	BOOST_FOREACH(Key key, i->second) {
+		ReservationMap::iterator r = _reservations.find(key);
+		if (r != _reservations.end() && r->second._monster == monster)
+			_reservations.erase(r);
+	}
+
+	_owners.erase(i);
+}
+
+void ReservationTable::syncState(Base::Serializer &s) {
+	s.syncUint(_width);
+
+	unsigned int count = static_cast<unsigned int>(_reservations.size());
+	s.syncCount(count, 3);
+
+	if (s.isSaving()) {
+		BOOST_FOREACH(ReservationMap::value_type &i, _reservations) {
+			Key key = i.first;
+			s.syncUint64(key);
+			s.syncUint(i.second._end);
+			s.syncUint(i.second._monster);
+		}
+	} else {
+		_reservations.clear();
+		_owners.clear();
+
+		// The owners are not saved, they follow from the
+		// reservations.
+		for (unsigned int i = 0; i < count; ++i) {
+			Key key = 0;
+			Reservation reservation;
+			s.syncUint64(key);
+			s.syncUint(reservation._end);
+			s.syncUint(reservation._monster);
+
+			_reservations[key] = reservation;
+			_owners[reservation._monster].push_back(key);
+		}
+	}
+}
+
+namespace {
+
+/**
+ * Calculates how many actions a monster at p needs at least
+ * to get next to the goal.
+ */
+unsigned int estimateCost(const Base::Point &p, const Base::Point &goal) {
+	const int dist = p.chebyshevDistanceTo(goal);
+	return (dist > 1) ? static_cast<unsigned int>(dist - 1) : 0;
+}
+
+/**
+ * An entry in the open list.
+ */
+struct OpenEntry {
+	unsigned int _estimate;
+	unsigned int _remaining;
+	int _node;
+
+	OpenEntry(unsigned int estimate, unsigned int remaining, int node)
+	    : _estimate(estimate), _remaining(remaining), _node(node) {}
+
+	bool operator<(const OpenEntry &e) const {
+		// std::priority_queue returns the biggest element first, but
+		// we want the entry with the lowest estimate. On ties we prefer
+		// entries which are closer to the goal.
+		if (_estimate != e._estimate)
+			return _estimate > e._estimate;
+		return _remaining > e._remaining;
+	}
+};
+
+enum {
+	/**
+	 * Maximum number of nodes expanded by a single search.
+	 */
+	kMaxExpansions = 512
+};
+
+/**
+ * Checks whether the player can travel over the given cell.
+ */
+bool isTravelPassable(const Game::Level &level, const Base::Point &p) {
+	const Game::Map &map = level.getMap();
+
+	if (static_cast<unsigned int>(p._x) >= map.getWidth() || static_cast<unsigned int>(p._y) >= map.getHeight())
+		return false;
+
+	if (!level.getPlayerView().isExplored(p))
+		return false;
+
+	const Game::TileDefinition &def = map.tileDefinition(p);
+	return def.getIsWalkable() && !def.getIsLiquid();
+}
+
+} // end of anonymous namespace
+
+bool findTravelPath(const Game::Level &level, const Base::Point &from, const Base::Point &to, Path &path) {
+	path.clear();
+
+	if (from == to || !isTravelPassable(level, to))
+		return false;
+
+	// A plain breadth first search is enough here, since every
+	// step has the same cost. It starts at the goal, so the path
+	// can be read front to back from the parents.
+	const unsigned int width = level.getMap().getWidth();
+	std::vector<int> parents(width * level.getMap().getHeight(), -1);
+	std::deque<Base::Point> open;
+
+	parents[to._y * width + to._x] = static_cast<int>(to._y * width + to._x);
+	open.push_back(to);
+
+	while (!open.empty()) {
+		const Base::Point pos = open.front();
+		open.pop_front();
+
+		for (unsigned char dir = 1; dir <= 9; ++dir) {
+			const Base::Point newPos = pos + Game::getDirection(dir);
+			if (newPos == pos)
+				continue;
+
+			if (newPos == from) {
+				for (Base::Point p = pos; p != to; ) {
+					path.push_back(p);
+					const int parent = parents[p._y * width + p._x];
+					p = Base::Point(parent % static_cast<int>(width), parent / static_cast<int>(width));
+				}
+				path.push_back(to);
+				return true;
+			}
+
+			if (!isTravelPassable(level, newPos) || parents[newPos._y * width + newPos._x] != -1)
+				continue;
+
+			parents[newPos._y * width + newPos._x] = static_cast<int>(pos._y * width + pos._x);
+			open.push_back(newPos);
+		}
+	}
+
+	return false;
+}
+
+CooperativePathFinder::CooperativePathFinder(const Game::Level &level, ReservationTable &reservations, unsigned int window)
+    : _level(level), _reservations(reservations), _window(window), _nodes() {
+	assert(_window > 0);
+}
+
+bool CooperativePathFinder::isPassable(const Base::Point &p) const {
+	const Game::Map &map = _level.getMap();
+
+	if (static_cast<unsigned int>(p._x) >= map.getWidth() || static_cast<unsigned int>(p._y) >= map.getHeight())
+		return false;
+
+	const Game::TileDefinition &def = map.tileDefinition(p);
+	return def.getIsWalkable() && !def.getIsLiquid();
+}
+
+bool CooperativePathFinder::findPath(Game::MonsterID monster, const Base::Point &goal, Game::TickCount startTick, Path &path) {
+	const Game::Monster *m = _level.getMonster(monster);
+	assert(m);
+
+	const Game::TickCount speed = m->getSpeed();
+	const unsigned int width = _level.getMap().getWidth();
+
+	_reservations.release(monster);
+	_nodes.clear();
+	path.clear();
+
+	// There is no point in searching, when the goal can not be
+	// reached at all.
+	if (!_level.getMap().isReachable(m->getPos(), goal))
+		return false;
+
+	std::priority_queue<OpenEntry> open;
+	std::set<uint64_t> closed;
+
+	_nodes.push_back(Node(m->getPos(), 0, 0, -1));
+	open.push(OpenEntry(estimateCost(m->getPos(), goal), estimateCost(m->getPos(), goal), 0));
+
+	int found = -1;
+	unsigned int expansions = 0;
+
+	while (!open.empty() && expansions < kMaxExpansions) {
+		const int cur = open.top()._node;
+		const unsigned int remaining = open.top()._remaining;
+		open.pop();
+
+		const Base::Point pos = _nodes[cur]._pos;
+		const unsigned int step = _nodes[cur]._step;
+
+		// Either the goal has been reached or the node is at the edge
+		// of the search window. In the latter case the estimate is all
+		// we know about the rest of the path, which is the whole idea
+		// of limiting the search to a window.
+		if (remaining == 0 || step == _window) {
+			found = cur;
+			break;
+		}
+
+		const uint64_t key = static_cast<uint64_t>(pos._y * width + pos._x) * (_window + 1) + step;
+		if (!closed.insert(key).second)
+			continue;
+		++expansions;
+
+		// The monster reaches the next position with its next action,
+		// and occupies it until the action after that.
+		const Game::TickCount arrival = startTick + step * speed;
+
+		for (unsigned char dir = 1; dir <= 9; ++dir) {
+			const Base::Point newPos = pos + Game::getDirection(dir);
+
+			if (newPos == goal || !isPassable(newPos))
+				continue;
+
+			// The first step is done right away, thus it has to respect
+			// the monsters currently placed on the level.
+			if (step == 0 && newPos != pos && !_level.isWalkable(newPos))
+				continue;
+
+			if (_reservations.isReserved(newPos, arrival, arrival + speed, monster))
+				continue;
+
+			const unsigned int cost = _nodes[cur]._cost + 1;
+			const unsigned int estimate = estimateCost(newPos, goal);
+
+			_nodes.push_back(Node(newPos, step + 1, cost, cur));
+			open.push(OpenEntry(cost + estimate, estimate, static_cast<int>(_nodes.size() - 1)));
+		}
+	}
+
+	// The start node itself might satisfy the goal already,
+	// which results in an empty path.
+	if (found < 0)
+		return false;
+
+	for (int i = found; _nodes[i]._parent != -1; i = _nodes[i]._parent)
+		path.push_front(_nodes[i]._pos);
+
+	Game::TickCount arrival = startTick;
+	BOOST_FOREACH(const Base::Point &p, path) {
+		_reservations.reserve(p, arrival, arrival + speed, monster);
+		arrival += speed;
+	}
+
+	return true;
+}
+
+} // end of namespace AI
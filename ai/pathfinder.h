@@ -0,0 +1,216 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AI_PATHFINDER_H
+#define AI_PATHFINDER_H
+
+#include "game/level.h"
+#include "game/monster.h"
+#include "game/defs.h"
+
+#include "base/geo.h"
+#include "base/serializer.h"
+
+#include <stdint.h>
+#include <map>
+#include <list>
+#include <deque>
+#include <vector>
+
+namespace AI {
+
+/**
+ * A space-time reservation table.
+ *
+ * Monsters, which plan their paths cooperatively, reserve the cells
+ * they are going to occupy for the ticks they are going to occupy
+ * them. Other monsters will then plan around these reservations
+ * instead of running into each other.
+ */
+class ReservationTable {
+public:
+	/**
+	 * Constructor for a reservation table.
+	 *
+	 * @param width Width of the map the reservations are made on.
+	 */
+	ReservationTable(unsigned int width) : _width(width), _reservations(), _owners() {}
+
+	/**
+	 * Checks whether the given cell is reserved by any other
+	 * monster in the tick range [from, to).
+	 *
+	 * @param p Position of the cell.
+	 * @param from First tick of the range.
+	 * @param to First tick after the range.
+	 * @param self Monster, whose reservations should be ignored.
+	 * @return true, when the cell is reserved, false otherwise.
+	 */
+	bool isReserved(const Base::Point &p, Game::TickCount from, Game::TickCount to, Game::MonsterID self) const;
+
+	/**
+	 * Reserves the given cell in the tick range [from, to).
+	 *
+	 * The caller has to assure that the cell is not reserved
+	 * by any other monster in that range.
+	 *
+	 * @param p Position of the cell.
+	 * @param from First tick of the range.
+	 * @param to First tick after the range.
+	 * @param monster Monster to reserve the cell for.
+	 */
+	void reserve(const Base::Point &p, Game::TickCount from, Game::TickCount to, Game::MonsterID monster);
+
+	/**
+	 * Releases all reservations of the given monster.
+	 *
+	 * @param monster Monster, whose reservations should be released.
+	 */
+	void release(Game::MonsterID monster);
+
+	/**
+	 * Saves or restores all reservations.
+	 *
+	 * @param s Serializer to use.
+	 */
+	void syncState(Base::Serializer &s);
+private:
+	unsigned int _width;
+
+	/**
+	 * The key of a reservation. The upper 32 bits are the cell index,
+	 * the lower 32 bits are the tick the reservation starts. This
+	 * keeps all reservations of a cell next to each other, ordered by
+	 * their start tick.
+	 */
+	typedef uint64_t Key;
+
+	Key makeKey(const Base::Point &p, Game::TickCount tick) const {
+		return (static_cast<Key>(p._y * _width + p._x) << 32) | tick;
+	}
+
+	/**
+	 * A single reservation.
+	 */
+	struct Reservation {
+		/**
+		 * First tick after the reservation.
+		 */
+		Game::TickCount _end;
+
+		/**
+		 * Monster owning the reservation.
+		 */
+		Game::MonsterID _monster;
+
+		Reservation() : _end(0), _monster(Game::kInvalidMonsterID) {}
+		Reservation(Game::TickCount end, Game::MonsterID monster) : _end(end), _monster(monster) {}
+	};
+
+	typedef std::map<Key, Reservation> ReservationMap;
+	ReservationMap _reservations;
+
+	typedef std::list<Key> KeyList;
+	typedef std::map<Game::MonsterID, KeyList> OwnerMap;
+	OwnerMap _owners;
+};
+
+/**
+ * A path, which is a list of positions. Every position is
+ * reached with one action of the monster. In case a position
+ * equals the previous one, the monster waits in place.
+ */
+typedef std::deque<Base::Point> Path;
+
+/**
+ * Finds the shortest path from one position to another, which
+ * only leads over cells the player explored already.
+ *
+ * Monsters are not taken into account, thus the path might be
+ * blocked when it is followed.
+ *
+ * @param level Level to search the path on.
+ * @param from Start position.
+ * @param to Goal position.
+ * @param path Where to store the path (excluding the start position).
+ * @return true, when a path was found, false otherwise.
+ */
+bool findTravelPath(const Game::Level &level, const Base::Point &from, const Base::Point &to, Path &path);
+
+/**
+ * A windowed cooperative A* path finder.
+ *
+ * It searches in space and time, but only for a fixed number of
+ * actions ahead. Beyond that window the remaining distance to the
+ * goal is only estimated. Found paths are reserved in the reservation
+ * table, thus monsters planning later will avoid them.
+ */
+class CooperativePathFinder {
+public:
+	/**
+	 * Constructor for the path finder.
+	 *
+	 * @param level Level to search paths on.
+	 * @param reservations Reservation table to use.
+	 * @param window How many actions to plan ahead.
+	 */
+	CooperativePathFinder(const Game::Level &level, ReservationTable &reservations, unsigned int window);
+
+	/**
+	 * Plans a path for the given monster, which will lead it next
+	 * to the given goal.
+	 *
+	 * This releases all reservations of the monster and reserves
+	 * the new path on success.
+	 *
+	 * @param monster Monster to plan for.
+	 * @param goal Position, the monster wants to get next to.
+	 * @param startTick Tick on which the monster can do its next action.
+	 * @param path Where to store the path (empty, when the monster is next to the goal already).
+	 * @return true, when a path was found, false otherwise.
+	 */
+	bool findPath(Game::MonsterID monster, const Base::Point &goal, Game::TickCount startTick, Path &path);
+private:
+	const Game::Level &_level;
+	ReservationTable &_reservations;
+	const unsigned int _window;
+
+	/**
+	 * A search node.
+	 */
+	struct Node {
+		Base::Point _pos;
+		unsigned int _step;
+		unsigned int _cost;
+		int _parent;
+
+		Node(const Base::Point &pos, unsigned int step, unsigned int cost, int parent)
+		    : _pos(pos), _step(step), _cost(cost), _parent(parent) {}
+	};
+
+	typedef std::vector<Node> NodeList;
+	NodeList _nodes;
+
+	bool isPassable(const Base::Point &p) const;
+};
+
+} // end of namespace AI
+
+#endif
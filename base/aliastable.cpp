@@ -0,0 +1,111 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "aliastable.h"
+
+#include <cassert>
+#include <algorithm>
+
+namespace Base {
+
+void AliasTable::setup(const WeightList &weights) {
+	const unsigned int count = static_cast<unsigned int>(weights.size());
+
+	uint64_t total = 0;
+	for (unsigned int i = 0; i < count; ++i)
+		total += weights[i];
+	assert(total <= 0xFFFFFFFF);
+
+	_total = static_cast<uint32_t>(total);
+	_threshold.assign(count, _total);
+	_alias.resize(count);
+	for (unsigned int i = 0; i < count; ++i)
+		_alias[i] = i;
+
+	if (!_total)
+		return;
+
+	// Every column holds an average weight of total / count. To stay
+	// with integers, all weights are scaled by count instead.
+	std::vector<uint64_t> scaled(count);
+	std::vector<unsigned int> small, large;
+	for (unsigned int i = 0; i < count; ++i) {
+		scaled[i] = static_cast<uint64_t>(weights[i]) * count;
+		if (scaled[i] < _total)
+			small.push_back(i);
+		else
+			large.push_back(i);
+	}
+
+	// Fill up every column with less than the average weight
+	// with the rest of a column with more than the average.
+	while (!small.empty() && !large.empty()) {
+		const unsigned int less = small.back(), more = large.back();
+		small.pop_back();
+		large.pop_back();
+
+		_threshold[less] = static_cast<uint32_t>(scaled[less]);
+		_alias[less] = more;
+
+		scaled[more] = scaled[more] + scaled[less] - _total;
+		if (scaled[more] < _total)
+			small.push_back(more);
+		else
+			large.push_back(more);
+	}
+
+	// The remaining columns are exactly full. Thanks to the integer
+	// calculations there are no rounding errors, which could leave
+	// any columns in the small list.
+	assert(small.empty());
+}
+
+unsigned int AliasTable::sample(RNG &rng) const {
+	assert(!empty());
+
+	const unsigned int column = rng.rndValueRange(0, size() - 1);
+	if (rng.rndValueRange(0, _total - 1) < _threshold[column])
+		return column;
+	else
+		return _alias[column];
+}
+
+void AliasTable::sample(RNG &rng, unsigned int *dst, unsigned int count) const {
+	assert(!empty());
+
+	enum {
+		kBatchSize = 64
+	};
+
+	unsigned int columns[kBatchSize], weights[kBatchSize];
+	while (count) {
+		const unsigned int n = std::min<unsigned int>(count, kBatchSize);
+		rng.fillRange(columns, n, 0, size() - 1);
+		rng.fillRange(weights, n, 0, _total - 1);
+
+		for (unsigned int i = 0; i < n; ++i)
+			dst[i] = (weights[i] < _threshold[columns[i]]) ? columns[i] : _alias[columns[i]];
+
+		dst += n;
+		count -= n;
+	}
+}
+
+} // end of namespace Base
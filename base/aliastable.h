@@ -0,0 +1,105 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BASE_ALIASTABLE_H
+#define BASE_ALIASTABLE_H
+
+#include "rnd.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Base {
+
+/**
+ * An alias table for weighted random choices.
+ *
+ * The table is built once with Vose's method. Afterwards every
+ * choice takes constant time, no matter how many entries there
+ * are. All computations are done on integers, thus the choices
+ * follow the weights exactly.
+ */
+class AliasTable {
+public:
+	typedef std::vector<uint32_t> WeightList;
+
+	AliasTable() : _total(0), _threshold(), _alias() {}
+
+	/**
+	 * Creates a table for the given weights.
+	 *
+	 * @param weights Weight of every entry.
+	 */
+	explicit AliasTable(const WeightList &weights) : _total(0), _threshold(), _alias() {
+		setup(weights);
+	}
+
+	/**
+	 * Builds the table for the given weights.
+	 *
+	 * Entries with a weight of 0 are never chosen. The sum of
+	 * all weights must fit into 32 bits.
+	 *
+	 * @param weights Weight of every entry.
+	 */
+	void setup(const WeightList &weights);
+
+	/**
+	 * @return the number of entries.
+	 */
+	unsigned int size() const { return static_cast<unsigned int>(_alias.size()); }
+
+	/**
+	 * Checks whether any entry can be chosen at all.
+	 *
+	 * @return true if no entry can be chosen, false otherwise.
+	 */
+	bool empty() const { return _total == 0; }
+
+	/**
+	 * Chooses a random entry.
+	 *
+	 * @param rng Random number generator to use.
+	 * @return Index of the entry (the table must not be empty).
+	 */
+	unsigned int sample(RNG &rng) const;
+
+	/**
+	 * Chooses multiple random entries.
+	 *
+	 * @param rng Random number generator to use.
+	 * @param dst Where to store the indices of the entries.
+	 * @param count How many entries to choose (the table must not be empty).
+	 */
+	void sample(RNG &rng, unsigned int *dst, unsigned int count) const;
+private:
+	uint32_t _total;
+
+	/**
+	 * For every column the threshold in [0, _total] below which
+	 * the column itself is chosen instead of its alias.
+	 */
+	std::vector<uint32_t> _threshold;
+	std::vector<unsigned int> _alias;
+};
+
+} // end of namespace Base
+
+#endif
@@ -0,0 +1,158 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BASE_BITPLANE_H
+#define BASE_BITPLANE_H
+
+#include <stdint.h>
+#include <vector>
+#include <cassert>
+
+namespace Base {
+
+/**
+ * A two dimensional, packed bit array.
+ *
+ * Every row starts at a new word, thus rows can be
+ * processed word by word.
+ */
+class BitPlane {
+public:
+	/**
+	 * The type of a single word of the plane.
+	 */
+	typedef uint32_t Word;
+
+	enum {
+		/**
+		 * How many bits are stored in a word.
+		 */
+		kWordBits = 32
+	};
+
+	BitPlane() : _width(0), _height(0), _pitch(0), _words() {}
+	BitPlane(unsigned int width, unsigned int height) : _width(0), _height(0), _pitch(0), _words() {
+		resize(width, height);
+	}
+
+	/**
+	 * Resizes the plane. This clears all bits.
+	 *
+	 * @param width New width.
+	 * @param height New height.
+	 */
+	void resize(unsigned int width, unsigned int height) {
+		_width = width;
+		_height = height;
+		_pitch = (width + kWordBits - 1) / kWordBits;
+		_words.assign(_pitch * _height, 0);
+	}
+
+	/**
+	 * @return the width of the plane.
+	 */
+	unsigned int getWidth() const { return _width; }
+
+	/**
+	 * @return the height of the plane.
+	 */
+	unsigned int getHeight() const { return _height; }
+
+	/**
+	 * @return how many words make up a row.
+	 */
+	unsigned int getPitch() const { return _pitch; }
+
+	/**
+	 * Queries the bit at the given position.
+	 *
+	 * @param x x coordinate (must not exceed width - 1)
+	 * @param y y coordinate (must not exceed height - 1)
+	 * @return whether the bit is set.
+	 */
+	bool get(unsigned int x, unsigned int y) const {
+		assert(x < _width && y < _height);
+		return (_words[y * _pitch + x / kWordBits] >> (x % kWordBits)) & 1;
+	}
+
+	/**
+	 * Sets the bit at the given position.
+	 *
+	 * @param x x coordinate (must not exceed width - 1)
+	 * @param y y coordinate (must not exceed height - 1)
+	 * @param value New value of the bit.
+	 */
+	void set(unsigned int x, unsigned int y, bool value = true) {
+		assert(x < _width && y < _height);
+		const Word mask = static_cast<Word>(1) << (x % kWordBits);
+		if (value)
+			_words[y * _pitch + x / kWordBits] |= mask;
+		else
+			_words[y * _pitch + x / kWordBits] &= ~mask;
+	}
+
+	/**
+	 * Clears all bits.
+	 */
+	void clear() {
+		_words.assign(_words.size(), 0);
+	}
+
+	/**
+	 * Sets all bits, which are set in the given plane.
+	 *
+	 * @param p Plane to merge (must be of the same size)
+	 */
+	void merge(const BitPlane &p) {
+		assert(p._width == _width && p._height == _height);
+		for (unsigned int i = 0; i < _words.size(); ++i)
+			_words[i] |= p._words[i];
+	}
+
+	/**
+	 * Returns the words of the given row.
+	 *
+	 * @param y Row to query (must not exceed height - 1)
+	 * @return Pointer to the first word of the row.
+	 */
+	const Word *getRow(unsigned int y) const {
+		assert(y < _height);
+		return &_words[y * _pitch];
+	}
+
+	/**
+	 * Returns the words of the given row.
+	 *
+	 * @param y Row to query (must not exceed height - 1)
+	 * @return Pointer to the first word of the row.
+	 */
+	Word *getRow(unsigned int y) {
+		assert(y < _height);
+		return &_words[y * _pitch];
+	}
+private:
+	unsigned int _width, _height;
+	unsigned int _pitch;
+	std::vector<Word> _words;
+};
+
+} // end of namespace Base
+
+#endif
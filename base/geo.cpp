@@ -20,7 +20,7 @@
 
 #include "geo.h"
 
-#include <cmath>
+#include <algorithm>
 
 namespace Base {
 
@@ -34,15 +34,26 @@ int abs(int value) {
 	return (value < 0) ? -value : value;
 }
 
-} // end of anonymous namespace
-
-double Point::distanceTo(const Point &p) const {
-	int xDiff = p._x - _x;
-	int yDiff = p._y - _y;
+/**
+ * Calculates the integer square root, i.e. the biggest
+ * number, whose square does not exceed the value.
+ */
+int isqrt(int value) {
+	if (value < 2)
+		return value;
+
+	// Newton's method on integers converges from above.
+	int x = value, y = (x + 1) / 2;
+	while (y < x) {
+		x = y;
+		y = (x + value / x) / 2;
+	}
 
-	return std::sqrt(xDiff*xDiff + yDiff*yDiff);
+	return x;
 }
 
+} // end of anonymous namespace
+
 Bresenham::Bresenham(const Point &start, const Point &end)
     : _start(start), _end(end), _cur(start) {
 	int dX = _end._x - _start._x;
@@ -89,5 +100,77 @@ const Point &Bresenham::getNext() {
 	return _cur;
 }
 
+RectIterator::RectIterator(const Rect &rect, const Rect &bounds)
+    : _rect(rect.intersect(bounds)), _cur(_rect._left, _rect._top) {
+	if (_rect.isEmpty())
+		_cur._y = _rect._bottom;
+}
+
+Point RectIterator::getNext() {
+	const Point result = _cur;
+
+	if (++_cur._x >= _rect._right) {
+		_cur._x = _rect._left;
+		++_cur._y;
+	}
+
+	return result;
+}
+
+RingIterator::RingIterator(const Circle &outer, int innerRadius, const Rect &bounds)
+    : _center(outer._center), _outerSquared(outer._radius * outer._radius),
+      _innerSquared((innerRadius < 0) ? -1 : innerRadius * innerRadius),
+      _clip(outer.getBounds().intersect(bounds)), _cur(_clip._left, _clip._top),
+      _rowEnd(0), _gapStart(1), _gapEnd(0) {
+	setupRow();
+}
+
+Point RingIterator::getNext() {
+	const Point result = _cur;
+
+	int x = _cur._x + 1;
+	if (x >= _gapStart && x <= _gapEnd)
+		x = _gapEnd + 1;
+
+	if (x <= _rowEnd) {
+		_cur._x = x;
+	} else {
+		++_cur._y;
+		setupRow();
+	}
+
+	return result;
+}
+
+void RingIterator::setupRow() {
+	// Look for the next row, which has any points left after
+	// clipping it.
+	for (; _cur._y < _clip._bottom; ++_cur._y) {
+		const int yDiff = _cur._y - _center._y;
+		const int outerSpan = isqrt(_outerSquared - yDiff * yDiff);
+
+		int x = std::max(_center._x - outerSpan, _clip._left);
+		_rowEnd = std::min(_center._x + outerSpan, _clip._right - 1);
+
+		if (_innerSquared >= yDiff * yDiff) {
+			const int innerSpan = isqrt(_innerSquared - yDiff * yDiff);
+			_gapStart = _center._x - innerSpan;
+			_gapEnd = _center._x + innerSpan;
+		} else {
+			// An empty gap.
+			_gapStart = 1;
+			_gapEnd = 0;
+		}
+
+		if (x >= _gapStart && x <= _gapEnd)
+			x = _gapEnd + 1;
+
+		if (x <= _rowEnd) {
+			_cur._x = x;
+			return;
+		}
+	}
+}
+
 } // end of namespace Base
 
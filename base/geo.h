@@ -96,16 +96,216 @@ struct Point {
 	}
 
 	/**
-	 * Calculates the distance between two points.
+	 * Calculates the squared euclidean distance between two points.
+	 *
+	 * Compare it against the squared threshold to check for
+	 * a maximum distance.
+	 *
+	 * @param p Point to calculate the distance with.
+	 * @return squared distance.
+	 */
+	int distanceSquaredTo(const Point &p) const {
+		const int xDiff = p._x - _x, yDiff = p._y - _y;
+		return xDiff * xDiff + yDiff * yDiff;
+	}
+
+	/**
+	 * Calculates the Chebyshev distance between two points. This
+	 * is the number of steps needed, when diagonal steps are allowed.
+	 *
+	 * @param p Point to calculate the distance with.
+	 * @return distance.
+	 */
+	int chebyshevDistanceTo(const Point &p) const {
+		const int xDiff = (p._x > _x) ? p._x - _x : _x - p._x;
+		const int yDiff = (p._y > _y) ? p._y - _y : _y - p._y;
+		return (xDiff > yDiff) ? xDiff : yDiff;
+	}
+
+	/**
+	 * Calculates the Manhattan distance between two points. This
+	 * is the number of steps needed without diagonal steps.
 	 *
 	 * @param p Point to calculate the distance with.
 	 * @return distance.
 	 */
-	double distanceTo(const Point &p) const;
+	int manhattanDistanceTo(const Point &p) const {
+		const int xDiff = (p._x > _x) ? p._x - _x : _x - p._x;
+		const int yDiff = (p._y > _y) ? p._y - _y : _y - p._y;
+		return xDiff + yDiff;
+	}
 
 	int _x, _y;
 };
 
+/**
+ * Structure representing a rectangle.
+ *
+ * The right and bottom edges are not part of the
+ * rectangle.
+ */
+struct Rect {
+	Rect() : _left(0), _top(0), _right(0), _bottom(0) {}
+	Rect(int left, int top, int right, int bottom) : _left(left), _top(top), _right(right), _bottom(bottom) {}
+
+	/**
+	 * Creates a rectangle, which covers a whole map of the given size.
+	 *
+	 * @param width Width of the map.
+	 * @param height Height of the map.
+	 */
+	Rect(unsigned int width, unsigned int height) : _left(0), _top(0), _right(width), _bottom(height) {}
+
+	int getWidth() const { return _right - _left; }
+	int getHeight() const { return _bottom - _top; }
+
+	/**
+	 * Checks whether the rectangle does not contain any point.
+	 *
+	 * @return true if empty, false otherwise.
+	 */
+	bool isEmpty() const { return _left >= _right || _top >= _bottom; }
+
+	/**
+	 * Checks whether the given point is inside the rectangle.
+	 *
+	 * @param p Point to check.
+	 * @return true if inside, false otherwise.
+	 */
+	bool contains(const Point &p) const {
+		return p._x >= _left && p._x < _right && p._y >= _top && p._y < _bottom;
+	}
+
+	/**
+	 * Calculates the intersection with another rectangle.
+	 *
+	 * @param r Rectangle to intersect with.
+	 * @return The intersection (might be empty).
+	 */
+	Rect intersect(const Rect &r) const {
+		return Rect((_left > r._left) ? _left : r._left, (_top > r._top) ? _top : r._top,
+		            (_right < r._right) ? _right : r._right, (_bottom < r._bottom) ? _bottom : r._bottom);
+	}
+
+	int _left, _top;
+	int _right, _bottom;
+};
+
+/**
+ * Structure representing a circle.
+ *
+ * A point is inside the circle, when its euclidean
+ * distance to the center does not exceed the radius.
+ */
+struct Circle {
+	Circle() : _center(), _radius(0) {}
+	Circle(const Point &center, int radius) : _center(center), _radius(radius) {}
+
+	/**
+	 * Checks whether the given point is inside the circle.
+	 *
+	 * @param p Point to check.
+	 * @return true if inside, false otherwise.
+	 */
+	bool contains(const Point &p) const {
+		return _center.distanceSquaredTo(p) <= _radius * _radius;
+	}
+
+	/**
+	 * @return the smallest rectangle containing the circle.
+	 */
+	Rect getBounds() const {
+		return Rect(_center._x - _radius, _center._y - _radius, _center._x + _radius + 1, _center._y + _radius + 1);
+	}
+
+	Point _center;
+	int _radius;
+};
+
+/**
+ * An object iterating over all points of a rectangle
+ * row by row.
+ */
+class RectIterator {
+public:
+	/**
+	 * Creates a new iterator.
+	 *
+	 * @param rect Rectangle to iterate over.
+	 * @param bounds Bounds to clip the rectangle to.
+	 */
+	RectIterator(const Rect &rect, const Rect &bounds);
+
+	/**
+	 * Checks whether all points have been returned already.
+	 */
+	bool finished() const { return _cur._y >= _rect._bottom; }
+
+	/**
+	 * Returns the next point.
+	 *
+	 * @return Next point.
+	 */
+	Point getNext();
+private:
+	const Rect _rect;
+	Point _cur;
+};
+
+/**
+ * An object iterating over all points of a ring row by
+ * row. A point is part of the ring, when it is inside
+ * the outer circle, but not inside the inner circle.
+ */
+class RingIterator {
+public:
+	/**
+	 * Creates a new iterator.
+	 *
+	 * @param outer Outer circle of the ring.
+	 * @param innerRadius Radius of the inner circle (a negative radius results in a disc).
+	 * @param bounds Bounds to clip the ring to.
+	 */
+	RingIterator(const Circle &outer, int innerRadius, const Rect &bounds);
+
+	/**
+	 * Checks whether all points have been returned already.
+	 */
+	bool finished() const { return _cur._y >= _clip._bottom; }
+
+	/**
+	 * Returns the next point.
+	 *
+	 * @return Next point.
+	 */
+	Point getNext();
+private:
+	const Point _center;
+	const int _outerSquared, _innerSquared;
+	const Rect _clip;
+
+	Point _cur;
+	int _rowEnd;
+	int _gapStart, _gapEnd;
+
+	void setupRow();
+};
+
+/**
+ * An object iterating over all points of a disc
+ * row by row.
+ */
+class DiscIterator : public RingIterator {
+public:
+	/**
+	 * Creates a new iterator.
+	 *
+	 * @param disc Disc to iterate over.
+	 * @param bounds Bounds to clip the disc to.
+	 */
+	DiscIterator(const Circle &disc, const Rect &bounds) : RingIterator(disc, -1, bounds) {}
+};
+
 /**
  * An object implementing the Bresenham algorithm.
  */
@@ -20,53 +20,246 @@
 
 #include "gui/intern/screen.h"
 #include "gui/intern/input.h"
+#include "gui/intern/cursesbackend.h"
+#include "gui/intern/ansibackend.h"
+#include "gui/intern/headlessbackend.h"
+#include "gui/intern/threadedbackend.h"
 
 #include "game/state.h"
 #include "game/game.h"
+#include "game/definitions.h"
+
+#include "server/host.h"
 
 #include "rnd.h"
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace {
+
+/**
+ * Reads the input script of a headless backend from stdin.
+ *
+ * The script always ends with the escape key. Only waiting for a
+ * key returns it, when the script is exhausted, but a real-time
+ * game never waits.
+ */
+void readKeyScript(GUI::Intern::NullBackend &backend) {
+	int key;
+	while ((key = std::getchar()) != EOF)
+		backend.addKey(key);
+	backend.addKey(GUI::kKeyEscape);
+}
+
+/**
+ * Runs a host for the games of many players.
+ *
+ * @param address TCP port on the local host or path of a Unix socket.
+ * @param idleTime Seconds after which idle games hibernate (0 to never hibernate).
+ * @param snapshotDirectory Directory to store the snapshots of hibernated games in.
+ */
+int runServer(const std::string &address, unsigned int idleTime, const std::string &snapshotDirectory) {
+	boost::shared_ptr<Game::Definitions> defs(new Game::Definitions());
+
+	try {
+		defs->load("./data");
+
+		Server::Host host(defs, static_cast<uint32_t>(std::time(0)));
+		if (address.find_first_not_of("0123456789") == std::string::npos)
+			host.listenTCP(boost::lexical_cast<unsigned short>(address));
+		else
+			host.listenUnix(address);
+
+		host.setHibernation(idleTime, snapshotDirectory);
+		host.run();
+	} catch (boost::bad_lexical_cast &) {
+		std::fprintf(stderr, "ERROR: Invalid port \"%s\"\n", address.c_str());
+		return -1;
+	} catch (Base::Exception &e) {
+		std::fprintf(stderr, "%s\n", e.toString().c_str());
+		return -1;
+	}
+
+	return 0;
+}
 
-int main(int /*argc*/, char ** /*argv*/) {
-	GUI::Intern::Screen::instance();
+} // end of anonymous namespace
 
-	if (GUI::Intern::Screen::instance().width() < 80 || GUI::Intern::Screen::instance().height() < 24) {
-		GUI::Intern::Screen::destroy();
+int main(int argc, char **argv) {
+	enum {
+		kBackendCurses,
+		kBackendANSI,
+		kBackendMemory,
+		kBackendNull
+	} backendType = kBackendCurses;
+	unsigned int watchRate = 0;
+	unsigned int tickRate = 0;
+	bool threaded = false;
+	std::string serverAddress;
+	unsigned int idleTime = 0;
+	std::string snapshotDirectory = std::getenv("TMPDIR") ? std::getenv("TMPDIR") : "/tmp";
+
+	for (int i = 1; i < argc; ++i) {
+		if (!std::strcmp(argv[i], "--ansi")) {
+			backendType = kBackendANSI;
+		} else if (!std::strcmp(argv[i], "--memory")) {
+			backendType = kBackendMemory;
+		} else if (!std::strcmp(argv[i], "--null")) {
+			backendType = kBackendNull;
+		} else if (!std::strcmp(argv[i], "--threaded")) {
+			threaded = true;
+		} else if (!std::strncmp(argv[i], "--watch=", 8)) {
+			try {
+				watchRate = boost::lexical_cast<unsigned int>(argv[i] + 8);
+			} catch (boost::bad_lexical_cast &) {
+				std::fprintf(stderr, "ERROR: Invalid frame rate \"%s\"\n", argv[i] + 8);
+				return -1;
+			}
+		} else if (!std::strncmp(argv[i], "--realtime=", 11)) {
+			try {
+				tickRate = boost::lexical_cast<unsigned int>(argv[i] + 11);
+			} catch (boost::bad_lexical_cast &) {
+				std::fprintf(stderr, "ERROR: Invalid tick rate \"%s\"\n", argv[i] + 11);
+				return -1;
+			}
+		} else if (!std::strncmp(argv[i], "--server=", 9) && argv[i][9]) {
+			serverAddress = argv[i] + 9;
+		} else if (!std::strncmp(argv[i], "--hibernate=", 12)) {
+			try {
+				idleTime = boost::lexical_cast<unsigned int>(argv[i] + 12);
+			} catch (boost::bad_lexical_cast &) {
+				std::fprintf(stderr, "ERROR: Invalid idle time \"%s\"\n", argv[i] + 12);
+				return -1;
+			}
+		} else if (!std::strncmp(argv[i], "--snapshots=", 12) && argv[i][12]) {
+			snapshotDirectory = argv[i] + 12;
+		} else {
+			std::fprintf(stderr, "Usage: %s [--ansi|--memory|--null] [--threaded] [--watch=FPS] [--realtime=TPS]\n", argv[0]);
+			std::fprintf(stderr, "       %s --server=PORT|PATH [--hibernate=SECONDS] [--snapshots=DIR]\n\n", argv[0]);
+			std::fprintf(stderr, "With --memory or --null no terminal is used, the keys are read from stdin.\n");
+			std::fprintf(stderr, "With --threaded rendering and input are done on their own threads.\n");
+			std::fprintf(stderr, "With --watch the monsters' moves between the player's turns are shown.\n");
+			std::fprintf(stderr, "With --realtime the game runs at the given ticks per second.\n");
+			std::fprintf(stderr, "With --server games are hosted for players connecting to the given\n");
+			std::fprintf(stderr, "TCP port on the local host or Unix socket. Their terminals must be in\n");
+			std::fprintf(stderr, "raw mode, e.g. \"socat -,rawer TCP:localhost:PORT\".\n");
+			std::fprintf(stderr, "With --hibernate games idle for the given time are saved to snapshot\n");
+			std::fprintf(stderr, "files in DIR (default $TMPDIR or /tmp) and restored on the next key.\n");
+			return -1;
+		}
+	}
+
+	if (!serverAddress.empty())
+		return runServer(serverAddress, idleTime, snapshotDirectory);
+
+	// ncurses is not thread safe, reading a key might refresh the
+	// terminal for example.
+	if (threaded && backendType == kBackendCurses) {
+		std::fprintf(stderr, "ERROR: --threaded requires --ansi, --memory or --null\n");
+		return -1;
+	}
+
+	GUI::Intern::Backend *backend = 0;
+	GUI::Intern::AnsiBackend *ansiBackend = 0;
+	GUI::Intern::NullBackend *headlessBackend = 0;
+	switch (backendType) {
+	case kBackendCurses:
+		backend = new GUI::Intern::CursesBackend();
+		break;
+
+	case kBackendANSI:
+		backend = ansiBackend = new GUI::Intern::AnsiBackend();
+		break;
+
+	case kBackendMemory:
+		backend = headlessBackend = new GUI::Intern::MemoryBackend();
+		readKeyScript(*headlessBackend);
+		break;
+
+	case kBackendNull:
+		backend = headlessBackend = new GUI::Intern::NullBackend();
+		readKeyScript(*headlessBackend);
+		break;
+	}
+
+	GUI::Intern::ThreadedBackend *threadedBackend = 0;
+	if (threaded)
+		backend = threadedBackend = new GUI::Intern::ThreadedBackend(backend);
+
+	GUI::Intern::Screen *screen = new GUI::Intern::Screen(backend);
+
+	const std::clock_t startTime = std::clock();
+
+	if (screen->width() < 80 || screen->height() < 24) {
+		delete screen;
 		std::fprintf(stderr, "ERROR: Terminal size must be at least 80x24\n");
 		return -1;
 	}
 
-	GUI::Intern::Input::instance();
-	Base::initRNG();
+	GUI::Intern::Input *input = new GUI::Intern::Input(*screen);
 
+	Game::TickStatistics tickStats;
 	try {
+		boost::shared_ptr<Game::Definitions> defs(new Game::Definitions());
+		defs->load("./data");
+
 		Game::StateHandler states;
-		states.addStateToQueue(new Game::GameState());
+		states.addStateToQueue(new Game::GameState(defs, *screen, *input, static_cast<uint32_t>(std::time(0)), watchRate, tickRate, &tickStats));
 		states.process();
 	} catch (const std::string &err) {
-		GUI::Intern::Screen::destroy();
-		GUI::Intern::Input::destroy();
+		delete input;
+		delete screen;
 
 		std::fprintf(stderr, "std::string exception: %s\n", err.c_str());
 
 		return -1;
 	} catch (Base::NonRecoverableException &e) {
-		GUI::Intern::Screen::destroy();
-		GUI::Intern::Input::destroy();
+		delete input;
+		delete screen;
 
 		std::fprintf(stderr, "%s\n", e.toString().c_str());
 
 		return -1;
 	} catch (Base::Exception &e) {
-		GUI::Intern::Screen::destroy();
-		GUI::Intern::Input::destroy();
+		delete input;
+		delete screen;
 
 		std::fprintf(stderr, "Uncaught exception: %s\n", e.toString().c_str());
 
 		return -1;
 	}
 
-	GUI::Intern::Screen::destroy();
-	GUI::Intern::Input::destroy();
+	const double cpuTime = static_cast<double>(std::clock() - startTime) / CLOCKS_PER_SEC;
+	uint64_t frames = 0, bytes = 0;
+	// Assure all frames are output before querying the statistics.
+	if (threadedBackend)
+		threadedBackend->finish();
+
+	if (ansiBackend) {
+		frames = ansiBackend->getFrameCount();
+		bytes = ansiBackend->getTotalBytes();
+	} else if (headlessBackend) {
+		frames = headlessBackend->getFrameCount();
+	}
+
+	delete input;
+	delete screen;
+
+	if (ansiBackend && frames)
+		std::fprintf(stderr, "Output: %lu bytes in %lu frames (%lu bytes per frame)\n",
+		             static_cast<unsigned long>(bytes), static_cast<unsigned long>(frames), static_cast<unsigned long>(bytes / frames));
+	else if (headlessBackend)
+		std::fprintf(stderr, "Output: %lu frames in %.3f s CPU time\n", static_cast<unsigned long>(frames), cpuTime);
+
+	if (tickStats._ticks)
+		std::fprintf(stderr, "Ticks: %lu, %lu overruns (up to %lu us late), %lu us per tick on average\n",
+		             static_cast<unsigned long>(tickStats._ticks), static_cast<unsigned long>(tickStats._overruns),
+		             static_cast<unsigned long>(tickStats._maxOverrun), static_cast<unsigned long>(tickStats._busyTime / tickStats._ticks));
 }
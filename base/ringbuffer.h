@@ -0,0 +1,121 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BASE_RINGBUFFER_H
+#define BASE_RINGBUFFER_H
+
+#include <cassert>
+#include <cstddef>
+
+namespace Base {
+
+/**
+ * A fixed capacity FIFO queue, which does not allocate
+ * any memory on its own.
+ *
+ * When an entry is added to a full buffer, the oldest
+ * entry is dropped.
+ */
+template<typename T, size_t kCapacity>
+class RingBuffer {
+public:
+	RingBuffer() : _head(0), _size(0) {}
+
+	/**
+	 * Checks whether the buffer is empty.
+	 *
+	 * @return true if empty, false otherwise.
+	 */
+	bool isEmpty() const { return !_size; }
+
+	/**
+	 * Returns the number of entries in the buffer.
+	 *
+	 * @return number of entries.
+	 */
+	size_t size() const { return _size; }
+
+	/**
+	 * Checks whether the buffer is full.
+	 *
+	 * @return true if full, false otherwise.
+	 */
+	bool isFull() const { return _size == kCapacity; }
+
+	/**
+	 * Adds an entry at the end of the buffer.
+	 *
+	 * @param entry Entry to add.
+	 */
+	void pushBack(const T &entry) {
+		if (_size == kCapacity) {
+			_head = (_head + 1) % kCapacity;
+			--_size;
+		}
+
+		_entries[(_head + _size) % kCapacity] = entry;
+		++_size;
+	}
+
+	/**
+	 * Returns the oldest entry of the buffer.
+	 *
+	 * @return oldest entry (the buffer must not be empty).
+	 */
+	const T &front() const {
+		assert(_size);
+		return _entries[_head];
+	}
+
+	/**
+	 * Returns an entry of the buffer.
+	 *
+	 * @param i Index of the entry, 0 is the oldest entry (must not exceed size - 1).
+	 * @return entry.
+	 */
+	const T &operator[](size_t i) const {
+		assert(i < _size);
+		return _entries[(_head + i) % kCapacity];
+	}
+
+	/**
+	 * Removes the oldest entry of the buffer.
+	 */
+	void popFront() {
+		assert(_size);
+		_head = (_head + 1) % kCapacity;
+		--_size;
+	}
+
+	/**
+	 * Removes all entries of the buffer.
+	 */
+	void clear() {
+		_head = _size = 0;
+	}
+private:
+	T _entries[kCapacity];
+	size_t _head, _size;
+};
+
+} // end of namespace Base
+
+#endif
+
@@ -19,48 +19,296 @@
  */
 
 #include "rnd.h"
+#include "serializer.h"
 
-#include <stdint.h>
-#include <ctime>
+#include <cassert>
+#include <algorithm>
+
+namespace Base {
 
 namespace {
-uint32_t g_rndSeed = 0;
+
+uint32_t rotl(uint32_t x, int k) {
+	return (x << k) | (x >> (32 - k));
 }
 
-namespace Base {
+/**
+ * Mixes the bits of the given value. This is used to turn
+ * similar seeds into very different states.
+ */
+uint32_t mix(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x7FEB352D;
+	x ^= x >> 15;
+	x *= 0x846CA68B;
+	x ^= x >> 16;
+	return x;
+}
+
+enum {
+	/**
+	 * How many raw numbers are generated at once by the
+	 * buffer fill functions.
+	 */
+	kBatchSize = 256,
+
+	/**
+	 * How many streams RNG::fill runs side by side.
+	 */
+	kLanes = 4,
+
+	/**
+	 * Buffers smaller than this are filled from the generator
+	 * itself, since setting up the streams is not worth it.
+	 */
+	kMinLaneFill = 32
+};
+
+/**
+ * Fills a buffer with random numbers in [offset, offset + range - 1]
+ * without any bias.
+ *
+ * The raw numbers are generated in batches. The rejection threshold
+ * is only calculated once, and rejected numbers are replaced with
+ * single numbers of the generator.
+ */
+void fillBounded(RNG &gen, unsigned int *dst, unsigned int count, uint32_t range, unsigned int offset) {
+	uint32_t buffer[kBatchSize];
+
+	// In case the range covers all values, it wraps to 0.
+	if (!range) {
+		while (count) {
+			const unsigned int n = std::min<unsigned int>(count, kBatchSize);
+			gen.fill(buffer, n);
+			for (unsigned int i = 0; i < n; ++i)
+				dst[i] = buffer[i];
+			dst += n;
+			count -= n;
+		}
+		return;
+	}
+
+	const uint32_t threshold = (0 - range) % range;
+	while (count) {
+		const unsigned int n = std::min<unsigned int>(count, kBatchSize);
+		gen.fill(buffer, n);
+
+		for (unsigned int i = 0; i < n; ++i) {
+			uint64_t m = static_cast<uint64_t>(buffer[i]) * range;
+			while (static_cast<uint32_t>(m) < threshold)
+				m = static_cast<uint64_t>(gen.next()) * range;
+			dst[i] = offset + static_cast<uint32_t>(m >> 32);
+		}
+
+		dst += n;
+		count -= n;
+	}
+}
+
+} // end of anonymous namespace
+
+RNG::RNG(uint32_t seed) {
+	// The mixing function is a bijection, thus the state is never
+	// all zero, which is the only invalid state.
+	for (int i = 0; i < 4; ++i) {
+		seed += 0x9E3779B9;
+		_state[i] = mix(seed);
+	}
+}
+
+uint32_t RNG::next() {
+	const uint32_t result = rotl(_state[1] * 5, 7) * 9;
+	const uint32_t t = _state[1] << 9;
+
+	_state[2] ^= _state[0];
+	_state[3] ^= _state[1];
+	_state[1] ^= _state[2];
+	_state[0] ^= _state[3];
+
+	_state[2] ^= t;
+	_state[3] = rotl(_state[3], 11);
+
+	return result;
+}
+
+void RNG::fill(uint32_t *dst, unsigned int count) {
+	if (count < kMinLaneFill) {
+		while (count--)
+			*dst++ = next();
+		return;
+	}
+
+	// Every lane is a stream of its own, which is seeded from this
+	// generator. The states are kept as structure of arrays, thus
+	// the loop over the lanes has no dependencies between its
+	// iterations and the compiler can process all lanes at once.
+	uint32_t s0[kLanes], s1[kLanes], s2[kLanes], s3[kLanes];
+	for (int lane = 0; lane < kLanes; ++lane) {
+		const RNG stream(next());
+		s0[lane] = stream._state[0];
+		s1[lane] = stream._state[1];
+		s2[lane] = stream._state[2];
+		s3[lane] = stream._state[3];
+	}
+
+	while (count >= kLanes) {
+		for (int lane = 0; lane < kLanes; ++lane) {
+			dst[lane] = rotl(s1[lane] * 5, 7) * 9;
+			const uint32_t t = s1[lane] << 9;
+
+			s2[lane] ^= s0[lane];
+			s3[lane] ^= s1[lane];
+			s1[lane] ^= s2[lane];
+			s0[lane] ^= s3[lane];
+
+			s2[lane] ^= t;
+			s3[lane] = rotl(s3[lane], 11);
+		}
+
+		dst += kLanes;
+		count -= kLanes;
+	}
 
-void initRNG() {
-	// TODO: Implement a nicer random number generator
-	g_rndSeed = (uint32_t)std::time(0);
+	while (count--)
+		*dst++ = next();
 }
 
-unsigned int rollDice(unsigned int pips) {
+void RNG::fillDice(unsigned int *dst, unsigned int count, unsigned int pips) {
+	if (!pips) {
+		std::fill(dst, dst + count, 0);
+		return;
+	}
+
+	fillBounded(*this, dst, count, pips, 1);
+}
+
+void RNG::fillRange(unsigned int *dst, unsigned int count, unsigned int min, unsigned int max) {
+	assert(min <= max);
+	fillBounded(*this, dst, count, max - min + 1, min);
+}
+
+void RNG::fillRanges(unsigned int *dst, const unsigned int *min, const unsigned int *max, unsigned int count) {
+	uint32_t buffer[kBatchSize];
+
+	while (count) {
+		const unsigned int n = std::min<unsigned int>(count, kBatchSize);
+		fill(buffer, n);
+
+		for (unsigned int i = 0; i < n; ++i) {
+			assert(min[i] <= max[i]);
+			const uint32_t range = max[i] - min[i] + 1;
+			if (!range) {
+				dst[i] = buffer[i];
+				continue;
+			}
+
+			uint64_t m = static_cast<uint64_t>(buffer[i]) * range;
+			if (static_cast<uint32_t>(m) < range) {
+				const uint32_t threshold = (0 - range) % range;
+				while (static_cast<uint32_t>(m) < threshold)
+					m = static_cast<uint64_t>(next()) * range;
+			}
+			dst[i] = min[i] + static_cast<uint32_t>(m >> 32);
+		}
+
+		dst += n;
+		min += n;
+		max += n;
+		count -= n;
+	}
+}
+
+void RNG::jump() {
+	static const uint32_t jumpTable[] = { 0x8764000B, 0xF542D2D3, 0x6FA035C3, 0x77F2DB5B };
+
+	uint32_t s[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 4; ++i) {
+		for (int b = 0; b < 32; ++b) {
+			if (jumpTable[i] & (static_cast<uint32_t>(1) << b)) {
+				for (int j = 0; j < 4; ++j)
+					s[j] ^= _state[j];
+			}
+			next();
+		}
+	}
+
+	for (int i = 0; i < 4; ++i)
+		_state[i] = s[i];
+}
+
+RNG RNG::split() {
+	RNG result(*this);
+	jump();
+	return result;
+}
+
+void RNG::syncState(Serializer &s) {
+	for (int i = 0; i < 4; ++i)
+		s.syncFixed(_state[i]);
+
+	// An all zero state would only ever produce zeros.
+	if (s.isLoading() && !(_state[0] | _state[1] | _state[2] | _state[3]))
+		throw Serializer::Exception("Invalid random state");
+}
+
+uint32_t RNG::bounded(uint32_t range) {
+	assert(range);
+
+	// Lemire's multiply and shift range reduction. Only values, which
+	// would introduce a bias, are rejected. This happens very rarely.
+	uint64_t m = static_cast<uint64_t>(next()) * range;
+	uint32_t low = static_cast<uint32_t>(m);
+
+	if (low < range) {
+		const uint32_t threshold = (0 - range) % range;
+		while (low < threshold) {
+			m = static_cast<uint64_t>(next()) * range;
+			low = static_cast<uint32_t>(m);
+		}
+	}
+
+	return static_cast<uint32_t>(m >> 32);
+}
+
+unsigned int RNG::rollDice(unsigned int pips) {
 	if (!pips)
 		return 0;
 
-	g_rndSeed = 0xDEADBF03 * (g_rndSeed + 1);
-	g_rndSeed = (g_rndSeed >> 13) | (g_rndSeed << 19);
-	return (g_rndSeed % pips) + 1;
+	return bounded(pips) + 1;
 }
 
-unsigned int rollDice(unsigned int num, unsigned int pips) {
+unsigned int RNG::rollDice(unsigned int num, unsigned int pips) {
+	unsigned int rolls[kBatchSize];
 	unsigned int count = 0;
-	while (num--)
-		count += rollDice(pips);
+
+	while (num) {
+		const unsigned int n = std::min<unsigned int>(num, kBatchSize);
+		fillDice(rolls, n, pips);
+		for (unsigned int i = 0; i < n; ++i)
+			count += rolls[i];
+		num -= n;
+	}
+
 	return count;
 }
 
-unsigned int rndValueRange(unsigned int min, unsigned int max) {
-	return min + rollDice(max - min + 1) - 1;
+unsigned int RNG::rndValueRange(unsigned int min, unsigned int max) {
+	assert(min <= max);
+
+	const uint32_t range = max - min + 1;
+	// In case the range covers all values, it wraps to 0.
+	if (!range)
+		return next();
+
+	return min + bounded(range);
 }
 
-unsigned int rndValueRange(const IntRange &range) {
+unsigned int RNG::rndValueRange(const IntRange &range) {
 	return rndValueRange(range.getMin(), range.getMax());
 }
 
-unsigned char rndValueRange(const ByteRange &range) {
+unsigned char RNG::rndValueRange(const ByteRange &range) {
 	return static_cast<unsigned char>(rndValueRange(range.getMin(), range.getMax()));
 }
 
 } // end of namespace Base
-
@@ -23,58 +23,158 @@
 
 #include "defs.h"
 
+#include <stdint.h>
+
 namespace Base {
 
-/**
- * Initializes our simple minded random number god.
- */
-void initRNG();
+class Serializer;
 
 /**
- * Rolls a dice with the given number of pips.
- * The result will in in [1, pips] and a
- * natural number.
+ * A random number generator.
  *
- * @param pips The pips count.
- * @return The result of the roll.
+ * This implements xoshiro128**. Every generator is a stream of its
+ * own, thus results are reproducible for the same seed no matter
+ * how other generators are used. Independent streams are created
+ * with split().
  */
-unsigned int rollDice(unsigned int pips);
+class RNG {
+public:
+	/**
+	 * Creates a new generator.
+	 *
+	 * @param seed Seed to initialize the state from.
+	 */
+	explicit RNG(uint32_t seed);
 
-/**
- * Rolls a given dice a given number of times.
- *
- * @param num How often to roll the dice.
- * @param pips The pips count.
- * @return The accumulated result of all rolls.
- */
-unsigned int rollDice(unsigned int num, unsigned int pips);
+	/**
+	 * Returns the next raw random number.
+	 *
+	 * @return Random number in [0, 2^32 - 1].
+	 */
+	uint32_t next();
 
-/**
- * Gets a random number in the given range.
- *
- * @param min Minimal value.
- * @param max Maximal value.
- * @return The random value.
- */
-unsigned int rndValueRange(unsigned int min, unsigned int max);
+	/**
+	 * Fills a buffer with raw random numbers.
+	 *
+	 * Small buffers get the same numbers as calling next() for
+	 * every entry. Larger buffers are filled by four xoshiro128**
+	 * streams side by side, which are seeded from this generator.
+	 * The result is reproducible for the same state, but differs
+	 * from calling next().
+	 *
+	 * @param dst Buffer to fill.
+	 * @param count Number of entries to fill.
+	 */
+	void fill(uint32_t *dst, unsigned int count);
 
-/**
- * Gets a random number in the given range.
- *
- * @param range The range
- * @return The random value.
- */
-unsigned int rndValueRange(const IntRange &range);
+	/**
+	 * Fills a buffer with dice rolls.
+	 *
+	 * @param dst Buffer to fill.
+	 * @param count Number of dice to roll.
+	 * @param pips The pips count.
+	 */
+	void fillDice(unsigned int *dst, unsigned int count, unsigned int pips);
 
-/**
- * Gets a random number in the given range.
- *
- * @param range The range
- * @return The random value.
- */
-unsigned char rndValueRange(const ByteRange &range);
+	/**
+	 * Fills a buffer with random numbers of the given range.
+	 *
+	 * @param dst Buffer to fill.
+	 * @param count Number of entries to fill.
+	 * @param min Minimal value.
+	 * @param max Maximal value.
+	 */
+	void fillRange(unsigned int *dst, unsigned int count, unsigned int min, unsigned int max);
+
+	/**
+	 * Fills a buffer with random numbers, where every entry
+	 * has a range of its own.
+	 *
+	 * @param dst Buffer to fill.
+	 * @param min Minimal value of every entry.
+	 * @param max Maximal value of every entry.
+	 * @param count Number of entries to fill.
+	 */
+	void fillRanges(unsigned int *dst, const unsigned int *min, const unsigned int *max, unsigned int count);
+
+	/**
+	 * Advances the generator by 2^64 numbers.
+	 */
+	void jump();
+
+	/**
+	 * Creates an independent generator.
+	 *
+	 * The new generator continues where this generator currently
+	 * is, while this generator is advanced by 2^64 numbers. Thus
+	 * both streams will not overlap in practice.
+	 *
+	 * @return The new generator.
+	 */
+	RNG split();
+
+	/**
+	 * Rolls a dice with the given number of pips.
+	 * The result will in in [1, pips] and a
+	 * natural number.
+	 *
+	 * @param pips The pips count.
+	 * @return The result of the roll.
+	 */
+	unsigned int rollDice(unsigned int pips);
+
+	/**
+	 * Rolls a given dice a given number of times.
+	 *
+	 * @param num How often to roll the dice.
+	 * @param pips The pips count.
+	 * @return The accumulated result of all rolls.
+	 */
+	unsigned int rollDice(unsigned int num, unsigned int pips);
+
+	/**
+	 * Gets a random number in the given range.
+	 *
+	 * @param min Minimal value.
+	 * @param max Maximal value.
+	 * @return The random value.
+	 */
+	unsigned int rndValueRange(unsigned int min, unsigned int max);
+
+	/**
+	 * Gets a random number in the given range.
+	 *
+	 * @param range The range
+	 * @return The random value.
+	 */
+	unsigned int rndValueRange(const IntRange &range);
+
+	/**
+	 * Gets a random number in the given range.
+	 *
+	 * @param range The range
+	 * @return The random value.
+	 */
+	unsigned char rndValueRange(const ByteRange &range);
+
+	/**
+	 * Saves or restores the state of the generator.
+	 *
+	 * @param s Serializer to use.
+	 */
+	void syncState(Serializer &s);
+private:
+	uint32_t _state[4];
+
+	/**
+	 * Returns a random number in [0, range - 1] without any bias.
+	 *
+	 * @param range Size of the range (must not be 0).
+	 * @return The random value.
+	 */
+	uint32_t bounded(uint32_t range);
+};
 
 } // end of namespace Base
 
 #endif
-
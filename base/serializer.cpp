@@ -0,0 +1,157 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "serializer.h"
+
+#include <cassert>
+
+namespace Base {
+
+Serializer::Serializer(const std::string *in, std::string *out) : _in(in), _out(out), _pos(0) {
+	assert((in != 0) != (out != 0));
+}
+
+void Serializer::syncUint(unsigned int &value) throw (Exception) {
+	if (isSaving()) {
+		writeVarint(value);
+	} else {
+		const uint64_t raw = readVarint();
+		if (raw > 0xFFFFFFFFU)
+			throw Exception("Integer out of range");
+		value = static_cast<unsigned int>(raw);
+	}
+}
+
+void Serializer::syncUint64(uint64_t &value) throw (Exception) {
+	if (isSaving())
+		writeVarint(value);
+	else
+		value = readVarint();
+}
+
+void Serializer::syncInt(int &value) throw (Exception) {
+	// The sign is moved into the lowest bit, thus small negative
+	// values are small too.
+	unsigned int raw = (static_cast<unsigned int>(value) << 1) ^ static_cast<unsigned int>(value < 0 ? -1 : 0);
+	syncUint(raw);
+	value = static_cast<int>(raw >> 1) ^ -static_cast<int>(raw & 1);
+}
+
+void Serializer::syncByte(unsigned char &value) throw (Exception) {
+	unsigned int raw = value;
+	syncUint(raw);
+	if (raw > 0xFF)
+		throw Exception("Byte out of range");
+	value = static_cast<unsigned char>(raw);
+}
+
+void Serializer::syncBool(bool &value) throw (Exception) {
+	unsigned char raw = value ? 1 : 0;
+	syncByte(raw);
+	value = (raw != 0);
+}
+
+void Serializer::syncFixed(uint32_t &value) throw (Exception) {
+	if (isSaving()) {
+		for (int i = 0; i < 4; ++i)
+			*_out += static_cast<char>((value >> (i * 8)) & 0xFF);
+	} else {
+		if (_in->size() - _pos < 4)
+			throw Exception("Unexpected end");
+
+		value = 0;
+		for (int i = 0; i < 4; ++i)
+			value |= static_cast<uint32_t>(static_cast<unsigned char>((*_in)[_pos++])) << (i * 8);
+	}
+}
+
+void Serializer::syncString(std::string &value) throw (Exception) {
+	unsigned int size = static_cast<unsigned int>(value.size());
+	syncUint(size);
+
+	if (isSaving()) {
+		*_out += value;
+	} else {
+		if (_in->size() - _pos < size)
+			throw Exception("Unexpected end");
+		value.assign(*_in, _pos, size);
+		_pos += size;
+	}
+}
+
+void Serializer::syncPoint(Point &value) throw (Exception) {
+	syncInt(value._x);
+	syncInt(value._y);
+}
+
+void Serializer::syncCount(unsigned int &count, unsigned int entrySize) throw (Exception) {
+	syncUint(count);
+	if (isLoading() && static_cast<uint64_t>(count) * entrySize > _in->size() - _pos)
+		throw Exception("Unexpected end");
+}
+
+void Serializer::syncBitPlane(BitPlane &value) throw (Exception) {
+	unsigned int width = value.getWidth(), height = value.getHeight();
+	syncUint(width);
+	syncUint(height);
+
+	if (isLoading()) {
+		const uint64_t pitch = (static_cast<uint64_t>(width) + BitPlane::kWordBits - 1) / BitPlane::kWordBits;
+		if (pitch * height * sizeof(BitPlane::Word) > _in->size() - _pos)
+			throw Exception("Unexpected end");
+		value.resize(width, height);
+	}
+
+	if (!value.getPitch())
+		return;
+
+	for (unsigned int y = 0; y < height; ++y) {
+		BitPlane::Word *row = value.getRow(y);
+		for (unsigned int w = 0; w < value.getPitch(); ++w)
+			syncFixed(row[w]);
+	}
+}
+
+uint64_t Serializer::readVarint() throw (Exception) {
+	uint64_t value = 0;
+
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		if (_pos >= _in->size())
+			throw Exception("Unexpected end");
+
+		const unsigned char byte = static_cast<unsigned char>((*_in)[_pos++]);
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+
+	throw Exception("Integer too long");
+}
+
+void Serializer::writeVarint(uint64_t value) {
+	while (value >= 0x80) {
+		*_out += static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	*_out += static_cast<char>(value);
+}
+
+} // end of namespace Base
+
@@ -0,0 +1,163 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BASE_SERIALIZER_H
+#define BASE_SERIALIZER_H
+
+#include "exception.h"
+#include "geo.h"
+#include "bitplane.h"
+
+#include <string>
+
+#include <stdint.h>
+
+namespace Base {
+
+/**
+ * Saves or loads the state of objects to or from a binary snapshot.
+ *
+ * Objects sync every member of their state with the serializer in
+ * one method, which is used for both saving and loading. Thus both
+ * directions can not get out of sync.
+ *
+ * Integers are stored as variable length quantities, small values
+ * only take a single byte that way.
+ */
+class Serializer {
+public:
+	/**
+	 * An exception thrown, when a snapshot is truncated or
+	 * contains invalid data.
+	 */
+	class Exception : public Base::Exception {
+	public:
+		Exception(const std::string &error) : _error(error) {}
+
+		std::string toString() const {
+			return "Invalid snapshot: " + _error;
+		}
+	private:
+		const std::string _error;
+	};
+
+	/**
+	 * Creates a serializer. Exactly one of the parameters must
+	 * be given.
+	 *
+	 * @param in Snapshot to load from (0 when saving).
+	 * @param out String to append the snapshot to (0 when loading).
+	 */
+	Serializer(const std::string *in, std::string *out);
+
+	/**
+	 * @return whether the state is saved.
+	 */
+	bool isSaving() const { return _out != 0; }
+
+	/**
+	 * @return whether the state is loaded.
+	 */
+	bool isLoading() const { return _in != 0; }
+
+	/**
+	 * Checks whether all data of the snapshot was loaded.
+	 *
+	 * @return true when at the end, false otherwise.
+	 */
+	bool isAtEnd() const { return !_in || _pos == _in->size(); }
+
+	void syncUint(unsigned int &value) throw (Exception);
+	void syncUint64(uint64_t &value) throw (Exception);
+	void syncInt(int &value) throw (Exception);
+	void syncByte(unsigned char &value) throw (Exception);
+	void syncBool(bool &value) throw (Exception);
+
+	/**
+	 * Syncs an integer with all its 32 bits. This is meant for
+	 * values, which are rarely small, like random states.
+	 *
+	 * @param value Value to sync.
+	 */
+	void syncFixed(uint32_t &value) throw (Exception);
+
+	/**
+	 * Syncs an enumeration value.
+	 *
+	 * @param value Value to sync.
+	 * @param last The last valid value, everything above is rejected when loading.
+	 */
+	template<typename T>
+	void syncEnum(T &value, T last) throw (Exception) {
+		unsigned int raw = static_cast<unsigned int>(value);
+		syncUint(raw);
+		if (raw > static_cast<unsigned int>(last))
+			throw Exception("Enumeration value out of range");
+		value = static_cast<T>(raw);
+	}
+
+	void syncString(std::string &value) throw (Exception);
+	void syncPoint(Point &value) throw (Exception);
+
+	/**
+	 * Syncs the number of entries of a list. When loading, the
+	 * count is rejected, when the snapshot is too short for that
+	 * many entries.
+	 *
+	 * @param count Count to sync.
+	 * @param entrySize The minimal size of an entry in bytes.
+	 */
+	void syncCount(unsigned int &count, unsigned int entrySize = 1) throw (Exception);
+
+	/**
+	 * Syncs a sequence of points, like a path.
+	 *
+	 * @param points Points to sync.
+	 */
+	template<typename Container>
+	void syncPoints(Container &points) throw (Exception) {
+		unsigned int count = static_cast<unsigned int>(points.size());
+		syncCount(count, 2);
+		if (isLoading())
+			points.resize(count);
+
+		for (typename Container::iterator i = points.begin(); i != points.end(); ++i)
+			syncPoint(*i);
+	}
+
+	/**
+	 * Syncs a bit plane including its size.
+	 *
+	 * @param value Plane to sync.
+	 */
+	void syncBitPlane(BitPlane &value) throw (Exception);
+private:
+	const std::string *const _in;
+	std::string *const _out;
+	std::string::size_type _pos;
+
+	uint64_t readVarint() throw (Exception);
+	void writeVarint(uint64_t value);
+};
+
+} // end of namespace Base
+
+#endif
+
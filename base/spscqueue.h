@@ -0,0 +1,102 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BASE_SPSCQUEUE_H
+#define BASE_SPSCQUEUE_H
+
+#include <boost/atomic.hpp>
+
+#include <vector>
+#include <cassert>
+#include <cstddef>
+
+namespace Base {
+
+/**
+ * A lock-free fixed capacity queue for passing data from one
+ * producer thread to one consumer thread.
+ */
+template<typename T>
+class SPSCQueue {
+public:
+	/**
+	 * Creates a queue.
+	 *
+	 * @param capacity Capacity of the queue (must be a power of two).
+	 */
+	explicit SPSCQueue(size_t capacity) : _entries(capacity), _mask(capacity - 1), _head(0), _tail(0) {
+		assert(capacity && !(capacity & _mask));
+	}
+
+	/**
+	 * Adds an entry to the queue. Only the producer may call this.
+	 *
+	 * @param entry Entry to add.
+	 * @return true on success, false when the queue is full.
+	 */
+	bool push(const T &entry) {
+		const size_t tail = _tail.load(boost::memory_order_relaxed);
+		if (tail - _head.load(boost::memory_order_acquire) > _mask)
+			return false;
+
+		_entries[tail & _mask] = entry;
+		_tail.store(tail + 1, boost::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Removes the oldest entry from the queue. Only the consumer
+	 * may call this.
+	 *
+	 * @param entry Where to store the entry.
+	 * @return true on success, false when the queue is empty.
+	 */
+	bool pop(T &entry) {
+		const size_t head = _head.load(boost::memory_order_relaxed);
+		if (head == _tail.load(boost::memory_order_acquire))
+			return false;
+
+		entry = _entries[head & _mask];
+		_head.store(head + 1, boost::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Checks whether the queue is empty.
+	 *
+	 * @return true if empty, false otherwise.
+	 */
+	bool isEmpty() const {
+		return _head.load(boost::memory_order_acquire) == _tail.load(boost::memory_order_acquire);
+	}
+private:
+	SPSCQueue(const SPSCQueue &);
+	SPSCQueue &operator=(const SPSCQueue &);
+
+	std::vector<T> _entries;
+	const size_t _mask;
+
+	boost::atomic<size_t> _head, _tail;
+};
+
+} // end of namespace Base
+
+#endif
+
@@ -0,0 +1,96 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "threadpool.h"
+
+#include <boost/bind/bind.hpp>
+
+namespace Base {
+
+ThreadPool::ThreadPool(unsigned int threads) : _workers(), _nextWorker(0) {
+	if (!threads)
+		threads = boost::thread::hardware_concurrency();
+	if (!threads)
+		threads = 1;
+
+	for (unsigned int i = 0; i < threads; ++i)
+		_workers.push_back(new Worker());
+}
+
+ThreadPool::~ThreadPool() {
+	for (WorkerList::iterator i = _workers.begin(); i != _workers.end(); ++i)
+		delete *i;
+}
+
+void ThreadPool::addTask(const Task &task) {
+	_workers[_nextWorker]->_tasks.push_back(task);
+	_nextWorker = (_nextWorker + 1) % getThreadCount();
+}
+
+void ThreadPool::run() {
+	boost::thread_group threads;
+	for (unsigned int i = 1; i < getThreadCount(); ++i)
+		threads.create_thread(boost::bind(&ThreadPool::workerLoop, this, i));
+
+	workerLoop(0);
+	threads.join_all();
+}
+
+bool ThreadPool::takeTask(unsigned int worker, Task &task) {
+	Worker &w = *_workers[worker];
+	boost::lock_guard<boost::mutex> lock(w._mutex);
+
+	if (w._tasks.empty())
+		return false;
+
+	task.swap(w._tasks.back());
+	w._tasks.pop_back();
+	return true;
+}
+
+bool ThreadPool::stealTask(unsigned int worker, Task &task) {
+	// Every thread starts looking at its neighbour, so the
+	// thieves do not all pick on the same queue.
+	for (unsigned int i = 1; i < getThreadCount(); ++i) {
+		Worker &victim = *_workers[(worker + i) % getThreadCount()];
+		boost::lock_guard<boost::mutex> lock(victim._mutex);
+
+		if (!victim._tasks.empty()) {
+			task.swap(victim._tasks.front());
+			victim._tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::workerLoop(unsigned int worker) {
+	// No tasks are added while the batch is run, thus once all
+	// queues are empty, there is nothing left to do.
+	Task task;
+	while (takeTask(worker, task) || stealTask(worker, task)) {
+		task();
+		task.clear();
+	}
+}
+
+} // end of namespace Base
+
@@ -0,0 +1,129 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BASE_THREADPOOL_H
+#define BASE_THREADPOOL_H
+
+#include <deque>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+namespace Base {
+
+/**
+ * A pool of threads, which processes a batch of tasks.
+ *
+ * Every thread has a queue of tasks of its own. A thread takes
+ * the tasks from the back of its own queue, and when it runs out
+ * of tasks, it steals from the front of the other threads' queues.
+ * Thus the threads hardly ever contend for a queue, and all of
+ * them are kept busy, even when the tasks take different amounts
+ * of time.
+ */
+class ThreadPool {
+public:
+	/**
+	 * A task to process. It must not throw any exception.
+	 */
+	typedef boost::function<void ()> Task;
+
+	/**
+	 * Creates a pool with the given number of threads.
+	 *
+	 * @param threads Number of threads (0 to use one per core).
+	 */
+	explicit ThreadPool(unsigned int threads = 0);
+	~ThreadPool();
+
+	/**
+	 * Returns the number of threads of the pool.
+	 *
+	 * @return thread count.
+	 */
+	unsigned int getThreadCount() const { return static_cast<unsigned int>(_workers.size()); }
+
+	/**
+	 * Adds a task to the batch. The tasks are spread evenly
+	 * over the threads' queues.
+	 *
+	 * This may not be called while the batch is run.
+	 *
+	 * @param task Task to add.
+	 */
+	void addTask(const Task &task);
+
+	/**
+	 * Processes all tasks added and waits until all of them
+	 * are finished. The calling thread is used as one of the
+	 * pool's threads.
+	 */
+	void run();
+private:
+	ThreadPool(const ThreadPool &);
+	ThreadPool &operator=(const ThreadPool &);
+
+	/**
+	 * The queue of a thread.
+	 */
+	struct Worker {
+		boost::mutex _mutex;
+		std::deque<Task> _tasks;
+	};
+
+	typedef std::vector<Worker *> WorkerList;
+	WorkerList _workers;
+
+	/**
+	 * The worker, which gets the next task added.
+	 */
+	unsigned int _nextWorker;
+
+	/**
+	 * Takes the next task from a worker's own queue.
+	 *
+	 * @param worker Index of the worker.
+	 * @param task Where to store the task.
+	 * @return true on success, false when the queue is empty.
+	 */
+	bool takeTask(unsigned int worker, Task &task);
+
+	/**
+	 * Steals a task from any other worker's queue.
+	 *
+	 * @param worker Index of the stealing worker.
+	 * @param task Where to store the task.
+	 * @return true on success, false when all queues are empty.
+	 */
+	bool stealTask(unsigned int worker, Task &task);
+
+	/**
+	 * Processes tasks until there are none left.
+	 *
+	 * @param worker Index of the worker.
+	 */
+	void workerLoop(unsigned int worker);
+};
+
+} // end of namespace Base
+
+#endif
+
@@ -0,0 +1,76 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BASE_TIMER_H
+#define BASE_TIMER_H
+
+#include <stdint.h>
+
+namespace Base {
+
+/**
+ * A timer measuring the time passed since it was started.
+ *
+ * It uses a monotonic clock, thus it is not affected by
+ * changes of the system time.
+ */
+class Timer {
+public:
+	/**
+	 * Creates a timer and starts it.
+	 */
+	Timer() : _start(getTime()) {}
+
+	/**
+	 * Starts the timer again.
+	 */
+	void reset() { _start = getTime(); }
+
+	/**
+	 * Returns the time passed since the timer was started.
+	 *
+	 * @return time in microseconds.
+	 */
+	uint64_t getElapsed() const { return getTime() - _start; }
+
+	/**
+	 * Returns the current time of the monotonic clock.
+	 *
+	 * @return time in microseconds.
+	 */
+	static uint64_t getTime();
+
+	/**
+	 * Sleeps until the monotonic clock reaches the given time.
+	 *
+	 * Since the time is absolute, delays of previous sleeps
+	 * do not add up, when it is used for periodic wake ups.
+	 *
+	 * @param time Time to wake up in microseconds.
+	 */
+	static void sleepUntil(uint64_t time);
+private:
+	uint64_t _start;
+};
+
+} // end of namespace Base
+
+#endif
+
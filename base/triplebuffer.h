@@ -0,0 +1,105 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BASE_TRIPLEBUFFER_H
+#define BASE_TRIPLEBUFFER_H
+
+#include <boost/atomic.hpp>
+
+namespace Base {
+
+/**
+ * A lock-free triple buffer for passing data from one producer
+ * thread to one consumer thread.
+ *
+ * The producer fills the back buffer and publishes it, the
+ * consumer takes the most recently published buffer as its front
+ * buffer. Neither side ever waits for the other one: a publish
+ * simply replaces a buffer, which was not taken yet.
+ */
+template<typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() : _middle(1), _back(0), _front(2) {}
+
+	/**
+	 * Returns the buffer the producer fills.
+	 *
+	 * @return back buffer.
+	 */
+	T &getBack() { return _buffers[_back]; }
+
+	/**
+	 * Publishes the back buffer. Afterwards the producer gets a
+	 * new back buffer, which content is undefined.
+	 */
+	void publish() {
+		_back = _middle.exchange(_back | kFresh, boost::memory_order_acq_rel) & kIndexMask;
+	}
+
+	/**
+	 * Checks whether a buffer was published, which the consumer
+	 * did not take yet.
+	 *
+	 * @return true if there is one, false otherwise.
+	 */
+	bool hasFresh() const { return (_middle.load(boost::memory_order_acquire) & kFresh) != 0; }
+
+	/**
+	 * Takes the most recently published buffer as front buffer.
+	 *
+	 * @return true if there was a new buffer, false otherwise.
+	 */
+	bool consume() {
+		if (!hasFresh())
+			return false;
+
+		_front = _middle.exchange(_front, boost::memory_order_acq_rel) & kIndexMask;
+		return true;
+	}
+
+	/**
+	 * Returns the buffer the consumer reads.
+	 *
+	 * @return front buffer.
+	 */
+	const T &getFront() const { return _buffers[_front]; }
+private:
+	TripleBuffer(const TripleBuffer &);
+	TripleBuffer &operator=(const TripleBuffer &);
+
+	static const unsigned int kIndexMask = 3;
+	static const unsigned int kFresh = 4;
+
+	T _buffers[3];
+
+	/**
+	 * The index of the buffer in the middle plus whether it
+	 * was published and not consumed yet.
+	 */
+	boost::atomic<unsigned int> _middle;
+
+	unsigned int _back, _front;
+};
+
+} // end of namespace Base
+
+#endif
+
@@ -0,0 +1,54 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "definitions.h"
+#include "maploader.h"
+
+namespace Game {
+
+Definitions::Definitions() : _monsters(), _tiles(), _baseMaps(), _baseMapMutex() {
+}
+
+void Definitions::load(const std::string &path) throw (Base::NonRecoverableException) {
+	_monsters.load(path + "/monster.def");
+	_tiles.load(path + "/tiles.def");
+}
+
+boost::shared_ptr<const BaseMap> Definitions::getBaseMap(const std::string &filename) const throw (Base::NonRecoverableException) {
+	// The lock is held while loading, so concurrent games
+	// wait for the map instead of loading it again.
+	boost::lock_guard<boost::mutex> lock(_baseMapMutex);
+
+	boost::shared_ptr<const BaseMap> &baseMap = _baseMaps[filename];
+	if (!baseMap) {
+		try {
+			MapLoader loader(filename, _tiles);
+			baseMap.reset(loader.load());
+		} catch (Base::NonRecoverableException &) {
+			_baseMaps.erase(filename);
+			throw;
+		}
+	}
+
+	return baseMap;
+}
+
+} // end of namespace Game
+
@@ -0,0 +1,92 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GAME_DEFINITIONS_H
+#define GAME_DEFINITIONS_H
+
+#include "monsterdatabase.h"
+#include "tiledatabase.h"
+#include "map.h"
+
+#include "base/exception.h"
+
+#include <string>
+#include <map>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace Game {
+
+/**
+ * All definitions a game is based upon.
+ *
+ * Once loaded the definitions never change, thus one
+ * object can be shared by any number of games. This also
+ * holds for the base maps, which are loaded on demand.
+ */
+class Definitions {
+public:
+	Definitions();
+
+	/**
+	 * Loads the definitions from the given data directory.
+	 *
+	 * @param path Path of the data directory.
+	 */
+	void load(const std::string &path) throw (Base::NonRecoverableException);
+
+	/**
+	 * Returns the monster database.
+	 *
+	 * @return monster database.
+	 */
+	const MonsterDatabase &getMonsterDatabase() const { return _monsters; }
+
+	/**
+	 * Returns the tile database.
+	 *
+	 * @return tile database.
+	 */
+	const TileDatabase &getTileDatabase() const { return _tiles; }
+
+	/**
+	 * Returns the base map stored in the given file.
+	 *
+	 * Every file is only loaded once, all later calls return
+	 * the same base map. This can be called from any thread.
+	 *
+	 * @param filename Filename of the map.
+	 * @return base map.
+	 */
+	boost::shared_ptr<const BaseMap> getBaseMap(const std::string &filename) const throw (Base::NonRecoverableException);
+private:
+	MonsterDatabase _monsters;
+	TileDatabase _tiles;
+
+	typedef std::map<std::string, boost::shared_ptr<const BaseMap> > BaseMapCache;
+	mutable BaseMapCache _baseMaps;
+	mutable boost::mutex _baseMapMutex;
+};
+
+} // end of namespace Game
+
+#endif
+
@@ -36,7 +36,12 @@ enum {
 	 * How many internal ticks are processed, before
 	 * the turn counter increases.
 	 */
-	kTicksPerTurn = 10
+	kTicksPerTurn = 10,
+
+	/**
+	 * How far the player can see.
+	 */
+	kPlayerSightRadius = 16
 };
 
 /**
@@ -114,7 +114,17 @@ public:
 		 * The monster is in a wary state and thus watching
 		 * the enviorment for changes.
 		 */
-		kWary
+		kWary,
+
+		/**
+		 * The monster waits for its planned path to clear.
+		 */
+		kWaiting,
+
+		/**
+		 * The monster rests to regain hit points.
+		 */
+		kResting
 	};
 
 	IdleEvent(const MonsterID monster, const Reason reason) : MonsterEvent(kTypeIdle, monster), _reason(reason) {}
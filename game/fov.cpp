@@ -0,0 +1,165 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "fov.h"
+
+#include <cassert>
+
+namespace Game {
+
+namespace {
+
+/**
+ * Divides a by b rounding towards negative infinity.
+ */
+int floorDiv(int a, int b) {
+	assert(b > 0);
+	return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
+
+/**
+ * Divides a by b rounding towards positive infinity.
+ */
+int ceilDiv(int a, int b) {
+	assert(b > 0);
+	return -floorDiv(-a, b);
+}
+
+} // end of anonymous namespace
+
+FieldOfView::FieldOfView(const Map &map, unsigned int radius)
+    : _map(map), _radius(radius), _visible(map.getWidth(), map.getHeight()), _explored(map.getWidth(), map.getHeight()),
+      _origin(), _sightRevision(0), _valid(false) {
+}
+
+void FieldOfView::syncState(Base::Serializer &s) {
+	s.syncBitPlane(_visible);
+	s.syncBitPlane(_explored);
+	s.syncPoint(_origin);
+	s.syncUint(_sightRevision);
+	s.syncBool(_valid);
+
+	if (s.isLoading()) {
+		if (_visible.getWidth() != _map.getWidth() || _visible.getHeight() != _map.getHeight()
+		    || _explored.getWidth() != _map.getWidth() || _explored.getHeight() != _map.getHeight())
+			throw Base::Serializer::Exception("Field of view does not match the map");
+	}
+}
+
+bool FieldOfView::update(const Base::Point &origin) {
+	if (_valid && _origin == origin && _sightRevision == _map.getSightRevision())
+		return false;
+
+	_origin = origin;
+	_sightRevision = _map.getSightRevision();
+	_valid = true;
+
+	compute();
+	return true;
+}
+
+void FieldOfView::compute() {
+	_visible.clear();
+
+	if (!isInside(_origin))
+		return;
+
+	reveal(_origin);
+	for (int quadrant = 0; quadrant < 4; ++quadrant)
+		scanRow(quadrant, 1, Slope(-1, 1), Slope(1, 1));
+
+	_explored.merge(_visible);
+}
+
+void FieldOfView::scanRow(int quadrant, int depth, Slope start, const Slope &end) {
+	if (depth > static_cast<int>(_radius))
+		return;
+
+	// The columns covered by the row are the ones, whose centers lie
+	// inside the slope range. Ties are rounded towards the inside.
+	// With a slope of num / den this results in:
+	//   floor(depth * num / den + 1/2) and ceil(depth * num / den - 1/2)
+	const int minCol = floorDiv(2 * depth * start._num + start._den, 2 * start._den);
+	const int maxCol = ceilDiv(2 * depth * end._num - end._den, 2 * end._den);
+
+	bool hasPrev = false, prevOpaque = false;
+	for (int col = minCol; col <= maxCol; ++col) {
+		const Base::Point p = transform(quadrant, depth, col);
+		const bool opaque = isOpaque(p);
+
+		// Floor tiles are only visible, when their center lies inside
+		// the slope range. This is what makes the algorithm symmetric.
+		if (opaque || (col * start._den >= depth * start._num && col * end._den <= depth * end._num))
+			reveal(p);
+
+		if (hasPrev) {
+			if (prevOpaque && !opaque) {
+				start = Slope(2 * col - 1, 2 * depth);
+			} else if (!prevOpaque && opaque) {
+				scanRow(quadrant, depth + 1, start, Slope(2 * col - 1, 2 * depth));
+			}
+		}
+
+		hasPrev = true;
+		prevOpaque = opaque;
+	}
+
+	if (hasPrev && !prevOpaque)
+		scanRow(quadrant, depth + 1, start, end);
+}
+
+Base::Point FieldOfView::transform(int quadrant, int depth, int col) const {
+	switch (quadrant) {
+	case 0:
+		return Base::Point(_origin._x + col, _origin._y - depth);
+
+	case 1:
+		return Base::Point(_origin._x + depth, _origin._y + col);
+
+	case 2:
+		return Base::Point(_origin._x + col, _origin._y + depth);
+
+	default:
+		return Base::Point(_origin._x - depth, _origin._y + col);
+	}
+}
+
+bool FieldOfView::isOpaque(const Base::Point &p) const {
+	// Everything outside the map is treated like a wall.
+	if (!isInside(p))
+		return true;
+	return _map.getSightPlane().get(p._x, p._y);
+}
+
+void FieldOfView::reveal(const Base::Point &p) {
+	if (!isInside(p))
+		return;
+
+	const int radius = static_cast<int>(_radius);
+
+	// Adding the radius once more gives a rounder circle than the
+	// plain euclidean distance check.
+	if (_origin.distanceSquaredTo(p) > radius * radius + radius)
+		return;
+
+	_visible.set(p._x, p._y);
+}
+
+} // end of namespace Game
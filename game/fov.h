@@ -0,0 +1,145 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GAME_FOV_H
+#define GAME_FOV_H
+
+#include "map.h"
+
+#include "base/geo.h"
+#include "base/bitplane.h"
+#include "base/serializer.h"
+
+namespace Game {
+
+/**
+ * The field of view of a viewer on a map.
+ *
+ * This uses symmetric shadowcasting on the map's sight plane,
+ * which means that whenever a viewer at A sees B, a viewer
+ * at B sees A too.
+ *
+ * Next to the currently visible tiles, it also keeps track of
+ * all tiles ever seen.
+ */
+class FieldOfView {
+public:
+	/**
+	 * Constructor for a field of view.
+	 *
+	 * @param map Map to look at.
+	 * @param radius How far the viewer can see.
+	 */
+	FieldOfView(const Map &map, unsigned int radius);
+
+	/**
+	 * Updates the field of view for the given viewer position.
+	 *
+	 * The field is only recomputed, when the viewer moved or
+	 * any tile started or stopped blocking the sight since
+	 * the last computation.
+	 *
+	 * @param origin Position of the viewer.
+	 * @return true, when the field was recomputed, false otherwise.
+	 */
+	bool update(const Base::Point &origin);
+
+	/**
+	 * Forces the field of view to be recomputed on the next update.
+	 */
+	void invalidate() { _valid = false; }
+
+	/**
+	 * Checks whether the given position is currently visible.
+	 *
+	 * @param p Position.
+	 * @return true if visible, false otherwise.
+	 */
+	bool isVisible(const Base::Point &p) const {
+		return isInside(p) && _visible.get(p._x, p._y);
+	}
+
+	/**
+	 * Checks whether the given position has ever been visible.
+	 *
+	 * @param p Position.
+	 * @return true if explored, false otherwise.
+	 */
+	bool isExplored(const Base::Point &p) const {
+		return isInside(p) && _explored.get(p._x, p._y);
+	}
+
+	/**
+	 * @return the plane of all currently visible tiles.
+	 */
+	const Base::BitPlane &getVisible() const { return _visible; }
+
+	/**
+	 * @return the plane of all tiles ever seen.
+	 */
+	const Base::BitPlane &getExplored() const { return _explored; }
+
+	/**
+	 * @return the position of the viewer.
+	 */
+	const Base::Point &getOrigin() const { return _origin; }
+
+	/**
+	 * Saves or restores the field of view. When restoring, the
+	 * map must already be restored.
+	 *
+	 * @param s Serializer to use.
+	 */
+	void syncState(Base::Serializer &s);
+private:
+	const Map &_map;
+	const unsigned int _radius;
+
+	Base::BitPlane _visible;
+	Base::BitPlane _explored;
+
+	Base::Point _origin;
+	unsigned int _sightRevision;
+	bool _valid;
+
+	bool isInside(const Base::Point &p) const {
+		return static_cast<unsigned int>(p._x) < _map.getWidth() && static_cast<unsigned int>(p._y) < _map.getHeight();
+	}
+
+	/**
+	 * A slope inside a quadrant, stored as fraction to
+	 * keep the computation exact.
+	 */
+	struct Slope {
+		int _num, _den;
+
+		Slope(int num, int den) : _num(num), _den(den) {}
+	};
+
+	void compute();
+	void scanRow(int quadrant, int depth, Slope start, const Slope &end);
+	Base::Point transform(int quadrant, int depth, int col) const;
+	bool isOpaque(const Base::Point &p) const;
+	void reveal(const Base::Point &p);
+};
+
+} // end of namespace Game
+
+#endif
@@ -23,20 +23,37 @@
 #include "game.h"
 #include "tiledatabase.h"
 #include "monsterdatabase.h"
+#include "message.h"
 
 #include "base/rnd.h"
+#include "base/timer.h"
+#include "base/serializer.h"
 
 #include "ai/monster.h"
+#include "ai/pathfinder.h"
 
 #include "gui/defs.h"
 
 #include <cassert>
-#include <sstream>
-#include <cmath>
+#include <algorithm>
 
 namespace Game {
 
-GameState::GameState() : _player(0) {
+namespace {
+
+/**
+ * The magic number ("HORT") and version of snapshots.
+ */
+const uint32_t kSnapshotMagic = 0x54524F48;
+const unsigned int kSnapshotVersion = 2;
+
+} // end of anonymous namespace
+
+GameState::GameState(boost::shared_ptr<const Definitions> defs, GUI::Intern::Screen &screen, GUI::Intern::Input &input,
+                     uint32_t seed, unsigned int watchRate, unsigned int tickRate, TickStatistics *stats,
+                     GameStatistics *gameStats)
+    : _definitions(defs), _nextMonsterID(kPlayerMonsterID + 1), _screen(screen), _input(input), _watchRate(watchRate), _tickRate(tickRate), _tickStats(stats), _gameStats(gameStats), _player(0), _rng(seed),
+      _mode(kModeTick), _selection(kSelectExamine), _selectedPos(), _autoAction(kAutoNone), _travelPath(), _monstersInView(), _newMonstersInView() {
 	_initialized = false;
 	_curLevel = 0;
 	_eventDisp = 0;
@@ -46,8 +63,10 @@ GameState::GameState() : _player(0) {
 }
 
 GameState::~GameState() {
-	delete _player;
+	// The level still refers to the player, thus it needs
+	// to be deleted first.
 	delete _curLevel;
+	delete _player;
 	delete _gameScreen;
 }
 
@@ -55,59 +74,260 @@ bool GameState::initialize() throw (Base::NonRecoverableException) {
 	if (!_initialized) {
 		_initialized = true;
 
-		g_monsterDatabase.load("./data/monster.def");
-		TileDatabase::instance().load("./data/tiles.def");
+		if (_gameStats) {
+			*_gameStats = GameStatistics();
+			_gameStats->_kills.resize(_definitions->getMonsterDatabase().getMonsterTypeCount());
+		}
 
-		_player = g_monsterDatabase.createNewMonster(kMonsterPlayer);
+		_player = _definitions->getMonsterDatabase().createNewMonster(kMonsterPlayer, _rng);
 		assert(_player);
-		LevelLoader *load = new LevelLoader("./data/levels/test");
+		LevelLoader *load = new LevelLoader("./data/levels/test", *_definitions);
 		_curLevel = load->load(*this);
 		assert(_curLevel);
 		delete load;
 
-		_gameScreen = new GUI::Screen(*_player);
-		_gameScreen->initialize();
-
 		_player->setPos(_curLevel->getStartPoint());
-		try {
-			_curLevel->makeActive(*_gameScreen, *_player);
-		} catch (std::out_of_range &e) {
-			throw Base::NonRecoverableException(e.what());
-		}
+		setupScreen();
 		_gameScreen->setCenter(_player->getPos());
+		_gameScreen->update();
 	}
 
 	return true;
 }
 
-bool GameState::run() {
+void GameState::setupScreen() throw (Base::NonRecoverableException) {
+	_gameScreen = new GUI::Screen(*_definitions, _screen, _input, *_player);
+	_gameScreen->initialize();
+	if (_watchRate)
+		_gameScreen->setFrameTimeCap(1000000 / _watchRate);
+
+	try {
+		_curLevel->makeActive(*_gameScreen, *_player);
+	} catch (std::out_of_range &e) {
+		throw Base::NonRecoverableException(e.what());
+	}
+}
+
+void GameState::saveSnapshot(std::string &snapshot) {
+	assert(_initialized && !_tickRate);
+
+	Base::Serializer s(0, &snapshot);
+	syncState(s);
+}
+
+void GameState::restoreSnapshot(const std::string &snapshot) throw (Base::Exception) {
+	assert(!_initialized);
+	_initialized = true;
+
+	Base::Serializer s(&snapshot, 0);
+	syncState(s);
+	if (!s.isAtEnd())
+		throw Base::Serializer::Exception("Unexpected data at the end");
+
 	_gameScreen->update();
+}
+
+void GameState::syncState(Base::Serializer &s) throw (Base::Exception) {
+	uint32_t magic = kSnapshotMagic;
+	unsigned int version = kSnapshotVersion;
+	s.syncFixed(magic);
+	s.syncUint(version);
+	if (magic != kSnapshotMagic || version != kSnapshotVersion)
+		throw Base::Serializer::Exception("Unknown format");
+
+	s.syncUint(_nextMonsterID);
+	s.syncUint(_tickCounter);
+	s.syncUint(_nextWarning);
+	s.syncEnum(_mode, kModeFinished);
+	s.syncEnum(_selection, kSelectTravel);
+	s.syncPoint(_selectedPos);
+	s.syncEnum(_autoAction, kAutoRest);
+	s.syncPoints(_travelPath);
+
+	unsigned int count = static_cast<unsigned int>(_monstersInView.size());
+	s.syncCount(count);
+	_monstersInView.resize(count);
+	for (unsigned int i = 0; i < count; ++i)
+		s.syncUint(_monstersInView[i]);
+
+	if (s.isLoading())
+		_player = new Monster();
+	_player->syncState(s);
+	if (_player->getType() != kMonsterPlayer)
+		throw Base::Serializer::Exception("Invalid player");
+
+	// Only the changes to the level's base map are stored, thus
+	// the base map is referred to by its file.
+	std::string baseMap;
+	if (s.isSaving())
+		baseMap = _curLevel->getMap().getBase().getFilename();
+	s.syncString(baseMap);
+
+	if (s.isLoading())
+		_curLevel = new Level(new Map(_definitions->getBaseMap(baseMap)), *this);
+	_curLevel->syncState(s);
+
+	if (s.isLoading())
+		setupScreen();
+	_curLevel->syncPlayerState(s);
+	_gameScreen->syncState(s);
+
+	// Creating the level splits a generator off the game's
+	// generator, thus it is restored last.
+	_rng.syncState(s);
+}
+
+bool GameState::run() {
+	if (_tickRate) {
+		runRealTime();
+		if (_gameStats)
+			_gameStats->_turns = _tickCounter / kTicksPerTurn;
+		return true;
+	}
+
+	while (!resume())
+		_gameScreen->waitForInput();
 
+	return true;
+}
+
+bool GameState::resume() {
 	GUI::Input input = GUI::kInputNone;
-	while (input != GUI::kInputQuit) {
-		_gameScreen->setTurn(_tickCounter / kTicksPerTurn);
 
-		if (_curLevel->isAllowedToAct(kPlayerMonsterID)) {
-			_gameScreen->update(true);
+	while (true) {
+		switch (_mode) {
+		case kModeTick:
+			_gameScreen->setTurn(_tickCounter / kTicksPerTurn);
+
+			if (_curLevel->isAllowedToAct(kPlayerMonsterID) && !continueAutoAction()) {
+				// Commands typed ahead are processed back to back,
+				// the screen is only drawn when waiting for the user
+				// or when there is anything to tell him.
+				if (_gameScreen->hasPendingMessages() || !_gameScreen->hasPendingInput())
+					_gameScreen->update(true);
+
+				_mode = kModeCommand;
+			} else {
+				finishTick(false);
+			}
+			break;
 
-			input = _gameScreen->getInput();
-			if (!handleInput(input))
-				continue;
+		case kModeCommand:
+			if (!_gameScreen->pollInput(input))
+				return false;
+
+			// Commands, which take no time, start over with the
+			// same tick.
+			_mode = kModeTick;
+			if (handleInput(input))
+				finishTick(input == GUI::kInputQuit);
+			break;
+
+		case kModeSelect:
+			if (!_gameScreen->pollInput(input))
+				return false;
+
+			selectPosition(input);
+			break;
+
+		case kModeDead:
+			if (!_gameScreen->pollInput(input))
+				return false;
+
+			_mode = kModeFinished;
+			break;
+
+		case kModeFinished:
+			if (_gameStats)
+				_gameStats->_turns = _tickCounter / kTicksPerTurn;
+			return true;
 		}
+	}
+}
 
-		_curLevel->update();
-		_gameScreen->update();
+void GameState::finishTick(bool quit) {
+	// The screen is only drawn, when the player is able to
+	// act again, everything in between can not be seen
+	// anyway (unless the player watches). Automatic actions
+	// are never watched, they should finish right away.
+	_curLevel->update();
+	if (_autoAction == kAutoNone)
+		_gameScreen->updateTick();
+
+	++_tickCounter;
 
+	if (!checkPlayerDeath() && quit)
+		_mode = kModeFinished;
+}
+
+void GameState::runRealTime() {
+	const uint64_t tickTime = 1000000 / _tickRate;
+	TickStatistics stats;
+
+	uint64_t deadline = Base::Timer::getTime();
+	while (true) {
+		const uint64_t tickStart = Base::Timer::getTime();
+		_gameScreen->setTurn(_tickCounter / kTicksPerTurn);
+
+		// Only commands entered already are processed, the
+		// game does not wait for the player.
+		if (_curLevel->isAllowedToAct(kPlayerMonsterID) && !continueAutoAction()) {
+			GUI::Input input = GUI::kInputNone;
+			while (_gameScreen->pollInput(input)) {
+				if (input == GUI::kInputQuit) {
+					if (_tickStats)
+						*_tickStats = stats;
+					return;
+				}
+
+				if (handleInput(input))
+					break;
+
+				// The game is paused, while a position is selected.
+				while (_mode == kModeSelect)
+					selectPosition(_gameScreen->getInput());
+			}
+		}
+
+		_curLevel->update();
 		++_tickCounter;
 
-		if (_player->getHitPoints() <= 0) {
-			_gameScreen->addToMsgWindow("You die...");
-			_gameScreen->update(true);
+		if (checkPlayerDeath()) {
 			_gameScreen->getInput();
 			break;
 		}
+
+		_gameScreen->update(true);
+
+		// The deadlines are absolute, thus the time to process
+		// a tick does not delay the following ticks. When a tick
+		// was too late, the ticks are not caught up though, so
+		// the game never runs faster than the tick rate.
+		const uint64_t now = Base::Timer::getTime();
+		deadline += tickTime;
+
+		++stats._ticks;
+		stats._busyTime += now - tickStart;
+		if (now > deadline) {
+			++stats._overruns;
+			stats._maxOverrun = std::max(stats._maxOverrun, now - deadline);
+			deadline = now;
+		} else {
+			Base::Timer::sleepUntil(deadline);
+		}
 	}
 
+	if (_tickStats)
+		*_tickStats = stats;
+}
+
+bool GameState::checkPlayerDeath() {
+	if (_player->getHitPoints() > 0)
+		return false;
+
+	addMessage(Message(kMsgYouDie));
+	_gameScreen->update(true);
+	_mode = kModeDead;
 	return true;
 }
 
@@ -118,38 +338,22 @@ void GameState::processMoveEvent(const MoveEvent &event) throw () {
 
 void GameState::processIdleEvent(const IdleEvent &event) throw () {
 	if (event.getMonster() == kPlayerMonsterID) {
-		// TODO: This should definitly not be stored over here
-		static const char * const messages[] = {
-			"You seem bored.",
-			"You yawn.",
-			"You nearly fall asleep."
-		};
-
-		if (Base::rollDice(10) == 10)
-			_gameScreen->addToMsgWindow(messages[Base::rollDice(3) - 1]);
+		if (event.getReason() != IdleEvent::kResting && _rng.rollDice(10) == 10)
+			addMessage(Message(static_cast<MessageTemplate>(kMsgYouAreBored + _rng.rollDice(3) - 1)));
 	} else {
 		const Monster *monster = _curLevel->getMonster(event.getMonster());
 		assert(monster);
 
-		if (Base::rollDice(20) == 20 && _player->getPos().distanceTo(monster->getPos()) <= 10.0f) {
-			std::stringstream ss;
+		if (_rng.rollDice(20) == 20 && _player->getPos().distanceSquaredTo(monster->getPos()) <= 10 * 10) {
+			Message msg(kMsgMonsterIsUnsure, monster->getType());
 			bool processMessage = true;
 
-			ss << "The " << g_monsterDatabase.getMonsterName(monster->getType()) << " ";
 			switch (event.getReason()) {
 			case IdleEvent::kNoReason:
-				ss << "seems unsure what to do next.";
 				break;
 
 			case IdleEvent::kWary: {
-				// TODO: This should definitly not be stored over here
-				static const char * const messages[] = {
-					"seems to be watching you.",
-					"makes you nervous.",
-					"seems to be aware of your presence."
-				};
-
-				ss << messages[Base::rollDice(3) - 1];
+				msg._template = static_cast<MessageTemplate>(kMsgMonsterWatchesYou + _rng.rollDice(3) - 1);
 
 				if (_nextWarning <= _tickCounter)
 					// TODO: How often the player has the chance to catch this
@@ -158,10 +362,15 @@ void GameState::processIdleEvent(const IdleEvent &event) throw () {
 				else
 					processMessage = false;
 				} break;
+
+			case IdleEvent::kWaiting:
+			case IdleEvent::kResting:
+				processMessage = false;
+				break;
 			}
 
 			if (processMessage)
-				_gameScreen->addToMsgWindow(ss.str());
+				addMessage(msg);
 		}
 	}
 }
@@ -170,47 +379,53 @@ void GameState::processDeathEvent(const DeathEvent &event) throw () {
 	const Monster *monster = _curLevel->getMonster(event.getMonster());
 	assert(monster);
 
-	if (_player->getPos().distanceTo(monster->getPos()) >= 10.0f)
+	// The outcome is recorded for all deaths, not only for
+	// those the player can see.
+	if (_gameStats) {
+		if (event.getMonster() == kPlayerMonsterID) {
+			_gameStats->_died = true;
+			_gameStats->_deathCause = event.getCause();
+			if (event.getCause() == DeathEvent::kKilled)
+				_gameStats->_killer = _curLevel->getMonster(event.getKiller())->getType();
+		} else if (event.getKiller() == kPlayerMonsterID) {
+			++_gameStats->_kills[monster->getType()];
+		}
+	}
+
+	if (_player->getPos().distanceSquaredTo(monster->getPos()) >= 10 * 10)
 		return;
 
 	if (event.getMonster() == kPlayerMonsterID) {
 		switch (event.getCause()) {
 		case DeathEvent::kDrowned:
-			_gameScreen->addToMsgWindow("You drown.");
+			addMessage(Message(kMsgYouDrown));
 			break;
 
 		case DeathEvent::kKilled: {
 			const Monster *killer = _curLevel->getMonster(event.getKiller());
 			assert(killer);
 
-			std::stringstream ss;
-			ss << "The " << g_monsterDatabase.getMonsterName(killer->getType()) << " kills you!";
-			_gameScreen->addToMsgWindow(ss.str());
+			addMessage(Message(kMsgMonsterKillsYou, killer->getType()));
 			} break;
 		}
 		
 	} else {
-		std::stringstream ss;
 		if (event.getKiller() == kPlayerMonsterID) {
-			ss << "You kill the " << g_monsterDatabase.getMonsterName(monster->getType()) << "!";
+			addMessage(Message(kMsgYouKillMonster, monster->getType()));
 		} else {
-			ss << "The " << g_monsterDatabase.getMonsterName(monster->getType());
-
 			switch (event.getCause()) {
 			case DeathEvent::kKilled: {
 				const Monster *killer = _curLevel->getMonster(event.getKiller());
 				assert(killer);
 
-				ss << " is killed by the " << g_monsterDatabase.getMonsterName(killer->getType()) << "!";
+				addMessage(Message(kMsgMonsterIsKilled, monster->getType(), killer->getType()));
 				} break;
 
 			case DeathEvent::kDrowned:
-				ss << " drowned.";
+				addMessage(Message(kMsgMonsterDrowned, monster->getType()));
 				break;
 			}
 		}
-
-		_gameScreen->addToMsgWindow(ss.str());
 	}
 }
 
@@ -224,31 +439,20 @@ void GameState::processAttackDamageEvent(const AttackDamageEvent &event) throw (
 	const Monster *target = _curLevel->getMonster(event.getTarget());
 	assert(target);
 
-	std::stringstream ss;
-
 	if (event.getTarget() == kPlayerMonsterID)
-		ss << "The " << g_monsterDatabase.g_monsterDatabase.getMonsterName(monster->getType()) << " hits you!";
+		addMessage(Message(event.getDidDmg() ? kMsgMonsterHitsYou : kMsgMonsterHitsYouNoDamage, monster->getType()));
 	else
-		ss << "You hit the " << g_monsterDatabase.getMonsterName(target->getType()) << "!";
-
-	if (!event.getDidDmg())
-		ss << " Somehow the attack does not cause any damage.";
-
-	_gameScreen->addToMsgWindow(ss.str());
+		addMessage(Message(event.getDidDmg() ? kMsgYouHitMonster : kMsgYouHitMonsterNoDamage, target->getType()));
 }
 
 void GameState::processAttackFailEvent(const AttackFailEvent &event) throw () {
 	const Monster *monster = _curLevel->getMonster(event.getMonster());
 	assert(monster);
 
-	std::stringstream ss;
-
 	if (event.getMonster() == kPlayerMonsterID)
-		ss << "You miss!";
+		addMessage(Message(kMsgYouMiss));
 	else
-		ss << "The " << g_monsterDatabase.getMonsterName(monster->getType()) << " misses!";
-
-	_gameScreen->addToMsgWindow(ss.str());
+		addMessage(Message(kMsgMonsterMisses, monster->getType()));
 }
 
 bool GameState::handleInput(GUI::Input input) {
@@ -268,7 +472,15 @@ bool GameState::handleInput(GUI::Input input) {
 		return false;
 
 	case GUI::kInputExamine:
-		examine();
+		startSelection(kSelectExamine, kMsgExamine);
+		return false;
+
+	case GUI::kInputTravel:
+		startSelection(kSelectTravel, kMsgTravel);
+		return false;
+
+	case GUI::kInputRest:
+		startAutoAction(kAutoRest);
 		return false;
 
 	case GUI::kInputDir1:
@@ -302,60 +514,127 @@ bool GameState::handleInput(GUI::Input input) {
 	return true;
 }
 
-void GameState::examine() {
-	Base::Point pos = _player->getPos();
+void GameState::startSelection(Selection selection, MessageTemplate prompt) {
+	_selection = selection;
+	_selectedPos = _player->getPos();
+	_mode = kModeSelect;
 
-	_gameScreen->addToMsgWindow("You are examining the environment now.");
+	addMessage(Message(prompt));
 	_gameScreen->update(true);
+}
 
-	GUI::Input input = GUI::kInputNone;
-	while (input != GUI::kInputQuit) {
-		input = _gameScreen->getInput();
-		Base::Point offset;
-
-		switch (input) {
-		case GUI::kInputDir1:
-		case GUI::kInputDir2:
-		case GUI::kInputDir3:
-		case GUI::kInputDir4:
-		case GUI::kInputDir6:
-		case GUI::kInputDir7:
-		case GUI::kInputDir8:
-		case GUI::kInputDir9:
-			offset = getDirection(input);
-			break;
+void GameState::selectPosition(GUI::Input input) {
+	Base::Point offset;
+
+	switch (input) {
+	case GUI::kInputDir1:
+	case GUI::kInputDir2:
+	case GUI::kInputDir3:
+	case GUI::kInputDir4:
+	case GUI::kInputDir6:
+	case GUI::kInputDir7:
+	case GUI::kInputDir8:
+	case GUI::kInputDir9:
+		offset = getDirection(input);
+		break;
+
+	case GUI::kInputDir5:
+		finishSelection(true);
+		return;
+
+	case GUI::kInputQuit:
+		finishSelection(false);
+		return;
 
-		case GUI::kInputDir5: {
-			input = GUI::kInputQuit;
+	default:
+		break;
+	}
+
+	const Base::Point newPos = _selectedPos + offset;
+	if (newPos._x >= 0 && static_cast<unsigned int>(newPos._x) < _curLevel->getMap().getWidth()
+	    && newPos._y >= 0 && static_cast<unsigned int>(newPos._y) < _curLevel->getMap().getHeight())
+		_selectedPos = newPos;
 
-			std::stringstream ss;
-			MonsterID monster = _curLevel->monsterAt(pos);
+	_gameScreen->setCenter(_selectedPos);
+	_gameScreen->update();
+}
+
+void GameState::finishSelection(bool selected) {
+	_mode = kModeTick;
+
+	switch (_selection) {
+	case kSelectExamine:
+		if (selected) {
+			MonsterID monster = _curLevel->monsterAt(_selectedPos);
 			if (monster != kInvalidMonsterID)
-				ss << "You see here a " << g_monsterDatabase.getMonsterName(_curLevel->getMonster(monster)->getType()) << ".";
+				addMessage(Message(kMsgExamineMonster, _curLevel->getMonster(monster)->getType()));
 			else
-				ss << "This is just a simple " << _curLevel->getMap().tileDefinition(pos).getName() << ".";
+				addMessage(Message(kMsgExamineTile, _curLevel->getMap().tileAt(_selectedPos)));
+		}
 
-			_gameScreen->addToMsgWindow(ss.str());
-			} break;
+		_gameScreen->setCenter(_player->getPos());
+		_gameScreen->update(true);
+		break;
 
-		default:
-			break;
+	case kSelectTravel:
+		if (selected && _selectedPos != _player->getPos()) {
+			if (AI::findTravelPath(*_curLevel, _player->getPos(), _selectedPos, _travelPath))
+				startAutoAction(kAutoTravel);
+			else
+				addMessage(Message(kMsgTravelNoPath));
 		}
 
-		if (input == GUI::kInputQuit)
-			break;
+		_gameScreen->setCenter(_player->getPos());
+		break;
+	}
+}
 
-		const Base::Point newPos = pos + offset;
-		if (newPos._x >= 0 && static_cast<unsigned int>(newPos._x) < _curLevel->getMap().getWidth()
-		    && newPos._y >= 0 && static_cast<unsigned int>(newPos._y) < _curLevel->getMap().getHeight())
-			pos = newPos;
+void GameState::startAutoAction(AutoAction action) {
+	_autoAction = action;
+	_curLevel->getMonstersInView(_monstersInView);
+}
 
-		_gameScreen->setCenter(pos);
-		_gameScreen->update();
+bool GameState::continueAutoAction() {
+	if (_autoAction == kAutoNone)
+		return false;
+
+	// Stop as soon as a monster shows up, which the player did
+	// not see the last time he could act.
+	_curLevel->getMonstersInView(_newMonstersInView);
+	const bool newMonster = !std::includes(_monstersInView.begin(), _monstersInView.end(), _newMonstersInView.begin(), _newMonstersInView.end());
+	_monstersInView.swap(_newMonstersInView);
+	if (newMonster) {
+		_autoAction = kAutoNone;
+		return false;
 	}
 
-	_gameScreen->setCenter(_player->getPos());
-	_gameScreen->update(true);
+	switch (_autoAction) {
+	case kAutoNone:
+		break;
+
+	case kAutoTravel:
+		if (!_travelPath.empty()) {
+			const Base::Point next = _travelPath.front();
+
+			// The path might be blocked by a monster now.
+			if (_player->getPos().chebyshevDistanceTo(next) == 1 && _curLevel->isWalkable(next)) {
+				_travelPath.pop_front();
+				_eventDisp->dispatch(new MoveEvent(kPlayerMonsterID, _player->getPos(), next));
+				return true;
+			}
+		}
+		break;
+
+	case kAutoRest:
+		if (_player->getHitPoints() < _player->getMaxHitPoints()) {
+			_eventDisp->dispatch(new IdleEvent(kPlayerMonsterID, IdleEvent::kResting));
+			return true;
+		}
+		break;
+	}
+
+	_autoAction = kAutoNone;
+	return false;
 }
 
 } // end of namespace Game
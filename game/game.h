@@ -23,28 +23,160 @@
 
 #include "state.h"
 #include "monster.h"
+#include "message.h"
+#include "definitions.h"
 #include "event.h"
 #include "defs.h"
 
 #include "gui/screen.h"
 #include "gui/defs.h"
 
+#include "base/rnd.h"
+#include "base/serializer.h"
+
 #include <list>
 #include <string>
+#include <deque>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
 
 namespace Game {
 
 class Level;
 
+/**
+ * Statistics about the ticks of a game in real time mode.
+ */
+struct TickStatistics {
+	/**
+	 * The number of ticks processed.
+	 */
+	uint64_t _ticks;
+
+	/**
+	 * The number of ticks, which were not finished in time.
+	 */
+	uint64_t _overruns;
+
+	/**
+	 * The longest time a tick was too late in microseconds.
+	 */
+	uint64_t _maxOverrun;
+
+	/**
+	 * The time spent processing ticks in microseconds. This
+	 * excludes the time slept until the next tick.
+	 */
+	uint64_t _busyTime;
+
+	TickStatistics() : _ticks(0), _overruns(0), _maxOverrun(0), _busyTime(0) {}
+};
+
+/**
+ * Statistics about the outcome of a game.
+ */
+struct GameStatistics {
+	/**
+	 * The number of turns the game lasted.
+	 */
+	unsigned int _turns;
+
+	/**
+	 * Whether the player died.
+	 */
+	bool _died;
+
+	/**
+	 * How the player died (only valid when he died).
+	 */
+	DeathEvent::Cause _deathCause;
+
+	/**
+	 * The type of the monster, which killed the player (only
+	 * valid when he was killed).
+	 */
+	MonsterType _killer;
+
+	/**
+	 * The number of monsters the player killed, indexed by the
+	 * monster type.
+	 */
+	std::vector<unsigned int> _kills;
+
+	GameStatistics() : _turns(0), _died(false), _deathCause(DeathEvent::kKilled), _killer(0), _kills() {}
+};
+
 class GameState : public State, public EventHandler {
 public:
-	GameState();
+	/**
+	 * Constructor for a new game.
+	 *
+	 * Usually the screen is only drawn, when the player can act.
+	 * When watching, the ticks in between are drawn too, but with
+	 * at most the given number of frames per second.
+	 *
+	 * In real time mode the ticks pass at a fixed rate, no matter
+	 * whether the player acts or not.
+	 *
+	 * All state of the game is owned by the game itself, only the
+	 * definitions are shared, thus multiple games can exist at once.
+	 *
+	 * @param defs Definitions the game is based upon.
+	 * @param screen Screen to draw the game on.
+	 * @param input Input to read the player's commands from.
+	 * @param seed Seed for all random numbers of the game.
+	 * @param watchRate Frames per second when watching (0 to not watch).
+	 * @param tickRate Ticks per second in real time mode (0 to disable).
+	 * @param stats Where to store the tick statistics in real time mode (may be 0).
+	 * @param gameStats Where to store the outcome of the game (may be 0).
+	 */
+	GameState(boost::shared_ptr<const Definitions> defs, GUI::Intern::Screen &screen, GUI::Intern::Input &input,
+	          uint32_t seed, unsigned int watchRate = 0, unsigned int tickRate = 0, TickStatistics *stats = 0,
+	          GameStatistics *gameStats = 0);
 	~GameState();
 
 	bool initialize() throw (Base::NonRecoverableException);
 
+	/**
+	 * Runs the game until it is finished.
+	 *
+	 * This waits for the player's input, use resume to run the
+	 * game without waiting instead.
+	 *
+	 * @see resume
+	 */
 	bool run();
 
+	/**
+	 * Runs the game until it needs input, which the player did
+	 * not enter yet. The game continues, where it stopped, when
+	 * this is called the next time.
+	 *
+	 * This does not support real time mode.
+	 *
+	 * @return true, when the game is finished, false when it waits
+	 *         for input.
+	 */
+	bool resume();
+
+	/**
+	 * Saves a snapshot of the game, which can be restored later,
+	 * even by another process. This does not support real time
+	 * mode and the game statistics are not included.
+	 *
+	 * @param snapshot String to append the snapshot to.
+	 */
+	void saveSnapshot(std::string &snapshot);
+
+	/**
+	 * Restores the game from a snapshot. This is used instead of
+	 * initialize and redraws the whole screen.
+	 *
+	 * @param snapshot Snapshot to restore.
+	 */
+	void restoreSnapshot(const std::string &snapshot) throw (Base::Exception);
+
 	void processMoveEvent(const MoveEvent &event) throw ();
 	void processIdleEvent(const IdleEvent &event) throw ();
 	void processDeathEvent(const DeathEvent &event) throw ();
@@ -57,20 +189,216 @@ public:
 	void setEventDispatcher(EventDispatcher *disp) { _eventDisp = disp; }
 
 	TickCount getCurrentTick() const { return _tickCounter; }
+
+	/**
+	 * Returns the definitions the game is based upon.
+	 *
+	 * @return definitions.
+	 */
+	const Definitions &getDefinitions() const { return *_definitions; }
+
+	/**
+	 * Creates a new monster id, which is unique in this game.
+	 *
+	 * @return The new id.
+	 */
+	MonsterID createMonsterID() { return _nextMonsterID++; }
+
+	/**
+	 * Creates a new random number generator, which is
+	 * independent of all others of the game.
+	 *
+	 * @return The new generator.
+	 */
+	Base::RNG createRNG() { return _rng.split(); }
 private:
 	bool _initialized;
 
+	boost::shared_ptr<const Definitions> _definitions;
+	MonsterID _nextMonsterID;
+
+	GUI::Intern::Screen &_screen;
+	GUI::Intern::Input &_input;
+
 	EventDispatcher *_eventDisp;
 
 	TickCount _tickCounter;
 	TickCount _nextWarning;
 
+	unsigned int _watchRate;
+	unsigned int _tickRate;
+	TickStatistics *_tickStats;
+	GameStatistics *_gameStats;
+
 	GUI::Screen *_gameScreen;
 	Level *_curLevel;
 	Monster *_player;
 
+	Base::RNG _rng;
+
+	/**
+	 * What the game does next. The game only stops in
+	 * the modes, which need input.
+	 */
+	enum Mode {
+		/**
+		 * The next tick is processed.
+		 */
+		kModeTick,
+
+		/**
+		 * The player enters his next command.
+		 */
+		kModeCommand,
+
+		/**
+		 * The player selects a position on the map.
+		 */
+		kModeSelect,
+
+		/**
+		 * The player died and the game waits for a final key.
+		 */
+		kModeDead,
+
+		/**
+		 * The game is finished.
+		 */
+		kModeFinished
+	};
+
+	Mode _mode;
+
+	/**
+	 * Creates the game screen and makes the current level active.
+	 */
+	void setupScreen() throw (Base::NonRecoverableException);
+
+	/**
+	 * Saves or restores the whole game.
+	 *
+	 * @param s Serializer to use.
+	 */
+	void syncState(Base::Serializer &s) throw (Base::Exception);
+
+	/**
+	 * Finishes the current tick, after the player did his
+	 * action (if any).
+	 *
+	 * @param quit Whether the player quit the game.
+	 */
+	void finishTick(bool quit);
+
+	/**
+	 * Runs the game in real time mode.
+	 *
+	 * @see run
+	 */
+	void runRealTime();
+
+	/**
+	 * Checks whether the player died and shows the last
+	 * message in that case. The game waits for a final key
+	 * then.
+	 *
+	 * @return true when the player died, false otherwise.
+	 */
+	bool checkPlayerDeath();
+
 	bool handleInput(GUI::Input input);
-	void examine();
+
+	/**
+	 * What a position is selected for.
+	 */
+	enum Selection {
+		kSelectExamine,
+		kSelectTravel
+	};
+
+	Selection _selection;
+	Base::Point _selectedPos;
+
+	/**
+	 * Lets the player select a position on the map. The selection
+	 * starts at the player's position.
+	 *
+	 * @param selection What the position is selected for.
+	 * @param prompt Message asking the player for the position.
+	 */
+	void startSelection(Selection selection, MessageTemplate prompt);
+
+	/**
+	 * Processes an input of the player, while he selects a position.
+	 *
+	 * @param input Input to process.
+	 */
+	void selectPosition(GUI::Input input);
+
+	/**
+	 * Does what the position was selected for.
+	 *
+	 * @param selected true, when a position was selected, false when aborted.
+	 */
+	void finishSelection(bool selected);
+
+	/**
+	 * Adds a message to the message window.
+	 *
+	 * This stops any automatic action of the player.
+	 *
+	 * @param msg Message to add.
+	 */
+	void addMessage(const Message &msg) {
+		_autoAction = kAutoNone;
+		_gameScreen->addToMsgWindow(msg);
+	}
+
+	/**
+	 * An action the player repeats without any input.
+	 */
+	enum AutoAction {
+		kAutoNone,
+
+		/**
+		 * The player travels along _travelPath.
+		 */
+		kAutoTravel,
+
+		/**
+		 * The player rests until his hit points are full.
+		 */
+		kAutoRest
+	};
+
+	AutoAction _autoAction;
+
+	/**
+	 * The positions the player still needs to travel to.
+	 *
+	 * @see AI::Path
+	 */
+	std::deque<Base::Point> _travelPath;
+
+	/**
+	 * The monsters the player saw, when he could act the last
+	 * time. An automatic action stops, when a new one shows up.
+	 */
+	std::vector<MonsterID> _monstersInView, _newMonstersInView;
+
+	/**
+	 * Starts an automatic action.
+	 *
+	 * @param action Action to start.
+	 */
+	void startAutoAction(AutoAction action);
+
+	/**
+	 * Does the next step of the current automatic action.
+	 *
+	 * @return true, when the player did an action, false when there
+	 *         is no automatic action (anymore).
+	 */
+	bool continueAutoAction();
 };
 
 } // end of namespace Game
@@ -32,7 +32,7 @@
 namespace Game {
 
 Level::Level(Map *map, GameState &gs)
-    : _map(map), _monsterField(), _screen(0), _gameState(gs), _eventDisp(), _monsters(), _monsterAI(0) {
+    : _map(map), _monsterField(), _playerView(*map, kPlayerSightRadius), _screen(0), _gameState(gs), _rng(gs.createRNG()), _eventDisp(), _monsters(), _monsterAI(0) {
 	assert(_map);
 
 	_monsterField.resize(_map->getWidth() * _map->getHeight());
@@ -40,7 +40,7 @@ Level::Level(Map *map, GameState &gs)
 		_monsterField[i] = false;
 
 	_eventDisp.addHandler(this);
-	_monsterAI = new AI::Monster(*this, _eventDisp);
+	_monsterAI = new AI::Monster(*this, _eventDisp, _rng.split());
 	_eventDisp.addHandler(_monsterAI);
 }
 
@@ -69,6 +69,8 @@ void Level::makeActive(GUI::Screen &screen, Monster &player) throw (std::out_of_
 	BOOST_FOREACH(const MonsterMap::value_type &i, _monsters)
 		screen.addObject(i.second._monster);
 	screen.addObject(&player);
+	_playerView.update(player.getPos());
+	screen.setFieldOfView(&_playerView);
 	_screen = &screen;
 
 	// Setup the game state to patch its events through the
@@ -100,8 +102,10 @@ void Level::makeInactive() {
 	_monsterAI->setPlayer(0);
 
 	// Uninitialize the screen 
-	if (_screen)
+	if (_screen) {
+		_screen->setFieldOfView(0);
 		_screen->setMap(0);
+	}
 	_screen = 0;
 
 	// Remove the game state from the event
@@ -113,6 +117,13 @@ void Level::makeInactive() {
 	_gameState.setEventDispatcher(0);
 }
 
+void Level::setTile(const Base::Point &p, const Tile tile) throw (std::out_of_range) {
+	_map->setTile(p, tile);
+
+	if (_screen)
+		_screen->flagTileChange(p);
+}
+
 bool Level::isWalkable(const Base::Point &p) const throw (std::out_of_range) {
 	if (!_map->isWalkable(p))
 		return false;
@@ -158,7 +169,7 @@ bool Level::isAllowedToAct(const MonsterID monster) const {
 
 MonsterID Level::addMonster(const MonsterType monster, const Base::Point &pos) throw (std::out_of_range) {
 	// Create a new monster object and setup the position.
-	std::auto_ptr<Monster> newMonster(g_monsterDatabase.createNewMonster(monster));
+	std::auto_ptr<Monster> newMonster(_gameState.getDefinitions().getMonsterDatabase().createNewMonster(monster, _rng));
 	assert(newMonster.get() != 0);
 	newMonster->setPos(pos);
 
@@ -169,9 +180,15 @@ MonsterID Level::addMonster(const MonsterType monster, const Base::Point &pos) t
 	_monsterField[pos._y * _map->getWidth() + pos._x] = true;
 
 	// Create a new monster ID and add the monster to the map
-	const MonsterID newId = createNewMonsterID();
+	const MonsterID newId = _gameState.createMonsterID();
 	_monsters[newId] = MonsterEntry(newMonster.get(), _gameState.getCurrentTick());
 
+	// Show the monster in case the level is displayed
+	if (_screen) {
+		_screen->addObject(newMonster.get());
+		_screen->flagForUpdate(pos);
+	}
+
 	// Add the monster to the AI handler
 	_monsterAI->addMonster(newId, newMonster.release());
 
@@ -197,6 +214,9 @@ void Level::removeMonster(const MonsterID monster) {
 
 		delete i->second._monster;
 		_monsterAI->removeMonster(i->first);
+	} else {
+		// The AI must not go after a player, who died or left the level.
+		_monsterAI->setPlayer(0);
 	}
 
 	// Remove the monster from the map
@@ -236,10 +256,77 @@ void Level::update() {
 		}
 	}
 
+	// Keep the player's view up to date, in case the map
+	// changed since the player moved last.
+	const Monster *player = getMonster(kPlayerMonsterID);
+	if (player)
+		_playerView.update(player->getPos());
+
 	// Process the AI
 	_monsterAI->update();
 }
 
+void Level::syncState(Base::Serializer &s) {
+	assert(s.isSaving() || (!_screen && _monsters.empty()));
+
+	_map->syncState(s);
+	if (s.isLoading())
+		_monsterField.assign(_map->getWidth() * _map->getHeight(), false);
+
+	_playerView.syncState(s);
+	s.syncPoint(_start);
+	_rng.syncState(s);
+
+	unsigned int count = static_cast<unsigned int>(_monsters.size() - _monsters.count(kPlayerMonsterID));
+	s.syncCount(count);
+
+	if (s.isSaving()) {
+		BOOST_FOREACH(MonsterMap::value_type &i, _monsters) {
+			if (i.first == kPlayerMonsterID)
+				continue;
+
+			MonsterID id = i.first;
+			s.syncUint(id);
+			s.syncUint(i.second._nextAction);
+			s.syncUint(i.second._nextRegeneration);
+			i.second._monster->syncState(s);
+		}
+	} else {
+		const MonsterDatabase &mdb = _gameState.getDefinitions().getMonsterDatabase();
+
+		for (unsigned int i = 0; i < count; ++i) {
+			MonsterID id = kInvalidMonsterID;
+			MonsterEntry entry;
+			s.syncUint(id);
+			s.syncUint(entry._nextAction);
+			s.syncUint(entry._nextRegeneration);
+
+			std::auto_ptr<Monster> monster(new Monster());
+			monster->syncState(s);
+
+			const Base::Point &pos = monster->getPos();
+			if (id == kPlayerMonsterID || _monsters.count(id) || monster->getType() >= mdb.getMonsterTypeCount()
+			    || static_cast<unsigned int>(pos._x) >= _map->getWidth() || static_cast<unsigned int>(pos._y) >= _map->getHeight())
+				throw Base::Serializer::Exception("Invalid monster");
+
+			_monsterField[pos._y * _map->getWidth() + pos._x] = true;
+			entry._monster = monster.get();
+			_monsters[id] = entry;
+			_monsterAI->addMonster(id, monster.release());
+		}
+	}
+
+	_monsterAI->syncState(s);
+}
+
+void Level::syncPlayerState(Base::Serializer &s) {
+	MonsterMap::iterator i = _monsters.find(kPlayerMonsterID);
+	assert(i != _monsters.end());
+
+	s.syncUint(i->second._nextAction);
+	s.syncUint(i->second._nextRegeneration);
+}
+
 void Level::processMoveEvent(const MoveEvent &event) throw () {
 	assert(isAllowedToAct(event.getMonster()));
 	Monster *monster = updateNextActionTick(event.getMonster());
@@ -255,6 +342,9 @@ void Level::processMoveEvent(const MoveEvent &event) throw () {
 	_monsterField[event.getNewPos()._y * _map->getWidth() + event.getNewPos()._x] = true;
 	monster->setPos(event.getNewPos());
 
+	if (event.getMonster() == kPlayerMonsterID)
+		_playerView.update(event.getNewPos());
+
 	try {
 		const TileDefinition &def = _map->tileDefinition(event.getNewPos());
 		if (def.getIsLiquid()) {
@@ -266,7 +356,10 @@ void Level::processMoveEvent(const MoveEvent &event) throw () {
 		assert(false && "New monster position is invalid");
 	}
 
-	_screen->flagForUpdate();
+	if (_screen) {
+		_screen->flagForUpdate(event.getOldPos());
+		_screen->flagForUpdate(event.getNewPos());
+	}
 }
 
 void Level::processIdleEvent(const IdleEvent &event) throw () {
@@ -285,7 +378,7 @@ void Level::processAttackEvent(const AttackEvent &event) throw () {
 	Monster *target = getMonster(event.getTarget());
 	assert(target);
 
-	if (Base::rollDice(20) == 20) {
+	if (_rng.rollDice(20) == 20) {
 		_eventDisp.dispatch(new AttackFailEvent(event.getMonster(), event.getTarget()));
 	} else {
 		int damage = 1;
@@ -310,6 +403,15 @@ void Level::processAttackFailEvent(const AttackFailEvent &/*event*/) throw () {
 	// Nothing to do here.
 }
 
+void Level::getMonstersInView(MonsterIDList &monsters) const {
+	monsters.clear();
+
+	for (MonsterMap::const_iterator i = _monsters.begin(); i != _monsters.end(); ++i) {
+		if (i->first != kPlayerMonsterID && _playerView.isVisible(i->second._monster->getPos()))
+			monsters.push_back(i->first);
+	}
+}
+
 Monster *Level::updateNextActionTick(MonsterID monster, bool oneTickOnly) {
 	MonsterMap::iterator i = _monsters.find(monster);
 	if (i != _monsters.end()) {
@@ -22,6 +22,7 @@
 #define GAME_LEVEL_H
 
 #include "map.h"
+#include "fov.h"
 #include "monster.h"
 #include "event.h"
 #include "game.h"
@@ -30,6 +31,8 @@
 #include "gui/screen.h"
 
 #include "base/geo.h"
+#include "base/rnd.h"
+#include "base/serializer.h"
 
 #include <list>
 #include <map>
@@ -89,6 +92,21 @@ public:
 	 */
 	const Map &getMap() const { return *_map; }
 
+	/**
+	 * Changes the tile at the given position.
+	 *
+	 * @param p Position.
+	 * @param tile New tile type.
+	 */
+	void setTile(const Base::Point &p, const Tile tile) throw (std::out_of_range);
+
+	/**
+	 * Returns the player's field of view on this level.
+	 *
+	 * @return field of view
+	 */
+	const FieldOfView &getPlayerView() const { return _playerView; }
+
 	/**
 	 * Checks whether the given position is walkable.
 	 *
@@ -122,6 +140,21 @@ public:
 	 */
 	const Monster *getMonster(const MonsterID monster) const;
 
+	/**
+	 * A list of monster ids.
+	 */
+	typedef std::vector<MonsterID> MonsterIDList;
+
+	/**
+	 * Queries all monsters, which the player can see right now.
+	 *
+	 * The player himself is not included. The ids are sorted
+	 * in ascending order.
+	 *
+	 * @param monsters Where to store the monster ids.
+	 */
+	void getMonstersInView(MonsterIDList &monsters) const;
+
 	/**
 	 * Checks whether the given monster is free to make
 	 * an action this tick.
@@ -131,6 +164,14 @@ public:
 	 */
 	bool isAllowedToAct(const MonsterID monster) const;
 
+	/**
+	 * Returns the current tick of the game the level
+	 * is associated with.
+	 *
+	 * @return current tick.
+	 */
+	TickCount getCurrentTick() const { return _gameState.getCurrentTick(); }
+
 	/**
 	 * Adds a monster to the level.
 	 *
@@ -163,6 +204,24 @@ public:
 	 * the monster's AI is processed.
 	 */
 	void update();
+
+	/**
+	 * Saves or restores the level, except for the player.
+	 *
+	 * A level is restored into a level created for an unchanged
+	 * map of the same base map, which must not be active.
+	 *
+	 * @param s Serializer to use.
+	 */
+	void syncState(Base::Serializer &s);
+
+	/**
+	 * Saves or restores, when the player can act and regenerates
+	 * next. The level must be active.
+	 *
+	 * @param s Serializer to use.
+	 */
+	void syncPlayerState(Base::Serializer &s);
 private:
 	/**
 	 * The map.
@@ -176,6 +235,13 @@ private:
 	 */
 	std::vector<bool> _monsterField;
 
+	/**
+	 * The field of view of the player. This is kept even
+	 * when the level is inactive, so the explored part of
+	 * the level is remembered.
+	 */
+	FieldOfView _playerView;
+
 	/**
 	 * The entrance of the level.
 	 */
@@ -192,6 +258,11 @@ private:
 	 */
 	GameState &_gameState;
 
+	/**
+	 * The random number generator of the level.
+	 */
+	Base::RNG _rng;
+
 	/**
 	 * The internal event dispatcher.
 	 * This is used to handle AI and game events.
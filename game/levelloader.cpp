@@ -19,34 +19,45 @@
  */
 
 #include "levelloader.h"
-#include "maploader.h"
-#include "monsterdatabase.h"
 
 #include <fstream>
 #include <cassert>
 
 #include <boost/lexical_cast.hpp>
+#include <boost/foreach.hpp>
 
 namespace Game {
 
-LevelLoader::LevelLoader(const std::string &path)
-    : _path(path), _level(0) {
+namespace {
+
+enum {
+	/**
+	 * How many random positions are tried for
+	 * placing a random monster.
+	 */
+	kMaxSpawnTries = 100
+};
+
+} // end of anonymous namespace
+
+LevelLoader::LevelLoader(const std::string &path, const Definitions &defs)
+    : _path(path), _definitions(defs), _level(0), _spawnTypes(), _spawnWeights(), _randomMonsters(0) {
 }
 
 Level *LevelLoader::load(GameState &gs) throw (Base::NonRecoverableException) {
-	MapLoader *mapLoader = new MapLoader(_path + "/map.def");
-	assert(mapLoader);
-
-	Map *map = mapLoader->load();
-	delete mapLoader;
+	Map *map = new Map(_definitions.getBaseMap(_path + "/map.def"));
+	assert(map);
 
 	_level = new Level(map, gs);
 	assert(_level);
 
 	Base::FileParser::RuleMap rules;
 	try {
+		rules["tile"] = Base::Rule("def-tile;%S,type;%D,x;%D,y");
 		rules["monster"] = Base::Rule("def-monster;%S,type;%D,x;%D,y");
 		rules["start-point"] = Base::Rule("def-start-point;%D,x;%D,y");
+		rules["spawn-weight"] = Base::Rule("def-spawn-weight;%S,type;%D,weight");
+		rules["random-monsters"] = Base::Rule("def-random-monsters;%D,count");
 
 		Base::FileParser parser(_path + "/objects.def", rules);
 		parser.parse(this);
@@ -57,6 +68,10 @@ Level *LevelLoader::load(GameState &gs) throw (Base::NonRecoverableException) {
 		throw Base::NonRecoverableException(e.toString());
 	}
 
+	// Random monsters are placed after all of the file has been
+	// parsed, so that they do not block any fixed positions.
+	spawnRandomMonsters();
+
 	Level *level = _level;
 	level->_start = _start;
 	_level = 0;
@@ -64,14 +79,52 @@ Level *LevelLoader::load(GameState &gs) throw (Base::NonRecoverableException) {
 }
 
 void LevelLoader::notifyRule(const std::string &name, const Base::Matcher::ValueMap &values) throw (Base::ParserListener::Exception) {
-	if (name == "monster")
+	if (name == "tile")
+		processTile(values);
+	else if (name == "monster")
 		processMonster(values);
 	else if (name == "start-point")
 		processStartPoint(values);
+	else if (name == "spawn-weight")
+		processSpawnWeight(values);
+	else if (name == "random-monsters")
+		processRandomMonsters(values);
 	else
 		throw Base::ParserListener::Exception("Unknown rule \"" + name + "\"");
 }
 
+void LevelLoader::processTile(const Base::Matcher::ValueMap &values) {
+	const std::string &type = values.find("type")->second;
+
+	unsigned int x, y;
+
+	try {
+		x = boost::lexical_cast<int>(values.find("x")->second);
+		y = boost::lexical_cast<int>(values.find("y")->second);
+	} catch (boost::bad_lexical_cast &) {
+		// This should never happen, since the values are
+		// prechecked by the parser.
+		assert(false && "Pre checked integer values for x/y turn out to be no integers");
+	}
+
+	const TileDatabase &tdb = _definitions.getTileDatabase();
+	const Tile tile = tdb.queryTile(type);
+	if (tile >= tdb.getTileCount())
+		throw Base::ParserListener::Exception("Undefined tile type \"" + type + '"');
+
+	const Base::Point pos(x, y);
+
+	// Monsters placed before must not end up inside the new tile.
+	if (_level->monsterAt(pos) != kInvalidMonsterID)
+		throw Base::ParserListener::Exception("Tile position is occupied by a monster");
+
+	try {
+		_level->setTile(pos, tile);
+	} catch (std::out_of_range &) {
+		throw Base::ParserListener::Exception("Tile position is out of range");
+	}
+}
+
 void LevelLoader::processMonster(const Base::Matcher::ValueMap &values) {
 	const std::string &type = values.find("type")->second;
 
@@ -92,7 +145,7 @@ void LevelLoader::processMonster(const Base::Matcher::ValueMap &values) {
 		if (!_level->isWalkable(pos))
 			throw Base::ParserListener::Exception("Position is blocked");
 
-		MonsterDatabase &mdb = g_monsterDatabase;
+		const MonsterDatabase &mdb = _definitions.getMonsterDatabase();
 		const MonsterType monType = mdb.queryMonsterType(type);
 		if (monType >= mdb.getMonsterTypeCount())
 			throw Base::ParserListener::Exception("Undefined monster type \"" + type + '"');
@@ -126,5 +179,75 @@ void LevelLoader::processStartPoint(const Base::Matcher::ValueMap &values) {
 	}
 }
 
+void LevelLoader::processSpawnWeight(const Base::Matcher::ValueMap &values) {
+	const std::string &type = values.find("type")->second;
+
+	int weight = 0;
+	try {
+		weight = boost::lexical_cast<int>(values.find("weight")->second);
+	} catch (boost::bad_lexical_cast &) {
+		// This should never happen, since the values are
+		// prechecked by the parser.
+		assert(false && "Pre checked integer value for weight turns out to be no integer");
+	}
+
+	if (weight < 0)
+		throw Base::ParserListener::Exception("Negative spawn weight");
+
+	const MonsterDatabase &mdb = _definitions.getMonsterDatabase();
+	const MonsterType monType = mdb.queryMonsterType(type);
+	if (monType >= mdb.getMonsterTypeCount())
+		throw Base::ParserListener::Exception("Undefined monster type \"" + type + '"');
+
+	_spawnTypes.push_back(monType);
+	_spawnWeights.push_back(static_cast<uint32_t>(weight));
+}
+
+void LevelLoader::processRandomMonsters(const Base::Matcher::ValueMap &values) {
+	int count = 0;
+	try {
+		count = boost::lexical_cast<int>(values.find("count")->second);
+	} catch (boost::bad_lexical_cast &) {
+		// This should never happen, since the values are
+		// prechecked by the parser.
+		assert(false && "Pre checked integer value for count turns out to be no integer");
+	}
+
+	if (count < 0)
+		throw Base::ParserListener::Exception("Negative random monster count");
+
+	_randomMonsters += static_cast<unsigned int>(count);
+}
+
+void LevelLoader::spawnRandomMonsters() throw (Base::NonRecoverableException) {
+	if (!_randomMonsters)
+		return;
+
+	const Base::AliasTable table(_spawnWeights);
+	if (table.empty())
+		throw Base::NonRecoverableException("Random monsters requested without any spawn weights");
+
+	Base::RNG &rng = _level->_rng;
+	const Map &map = _level->getMap();
+
+	// Choose the types of all monsters at once.
+	std::vector<unsigned int> types(_randomMonsters);
+	table.sample(rng, &types[0], _randomMonsters);
+
+	BOOST_FOREACH(unsigned int type, types) {
+		// Try a limited number of random positions, in case the
+		// level is nearly full we simply skip the monster.
+		for (int tries = 0; tries < kMaxSpawnTries; ++tries) {
+			const Base::Point pos(rng.rndValueRange(0, map.getWidth() - 1), rng.rndValueRange(0, map.getHeight() - 1));
+
+			if (pos == _start || !_level->isWalkable(pos) || map.tileDefinition(pos).getIsLiquid())
+				continue;
+
+			_level->addMonster(_spawnTypes[type], pos);
+			break;
+		}
+	}
+}
+
 } // end of namespace Game
 
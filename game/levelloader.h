@@ -23,12 +23,15 @@
 
 #include "game.h"
 #include "level.h"
+#include "definitions.h"
 
 #include "base/parser.h"
 #include "base/geo.h"
+#include "base/aliastable.h"
 
 #include <string>
 #include <list>
+#include <vector>
 
 namespace Game {
 
@@ -37,14 +40,24 @@ namespace Game {
  *
  * It loads the map from "path/map.def"
  * and the objects on the map from "path/objects.def"
+ *
+ * Next to monsters at fixed positions, the objects file
+ * can request monsters at random positions. Their types
+ * are chosen based on the spawn weights of the file.
+ *
+ * The objects file can also place tiles over the map, thus
+ * levels can share a map and still differ in some tiles.
  */
 class LevelLoader : private Base::ParserListener {
 public:
 	/**
 	 * Creates a level loader, which loads from the
 	 * given path.
+	 *
+	 * @param path Path of the level.
+	 * @param defs Definitions the level is based upon.
 	 */
-	LevelLoader(const std::string &path);
+	LevelLoader(const std::string &path, const Definitions &defs);
 	~LevelLoader() { delete _level; }
 
 	/**
@@ -56,13 +69,27 @@ public:
 	Level *load(GameState &gs) throw (Base::NonRecoverableException);
 private:
 	const std::string _path;
+	const Definitions &_definitions;
 
 	void notifyRule(const std::string &name, const Base::Matcher::ValueMap &values) throw (Base::ParserListener::Exception);
+	void processTile(const Base::Matcher::ValueMap &values);
 	void processMonster(const Base::Matcher::ValueMap &values);
 	void processStartPoint(const Base::Matcher::ValueMap &values);
+	void processSpawnWeight(const Base::Matcher::ValueMap &values);
+	void processRandomMonsters(const Base::Matcher::ValueMap &values);
+
+	/**
+	 * Places all randomly spawned monsters on the level.
+	 */
+	void spawnRandomMonsters() throw (Base::NonRecoverableException);
 
 	Base::Point _start;
 	Level *_level;
+
+	typedef std::vector<MonsterType> MonsterTypeList;
+	MonsterTypeList _spawnTypes;
+	Base::AliasTable::WeightList _spawnWeights;
+	unsigned int _randomMonsters;
 };
 
 } // end of namespace Game
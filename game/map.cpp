@@ -21,19 +21,276 @@
 #include "map.h"
 
 #include "tiledatabase.h"
+#include "defs.h"
 
 #include <cassert>
+#include <deque>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
 
 namespace Game {
 
-Map::Map(unsigned int width, unsigned int height, const std::vector<Tile> &tiles)
-    : _width(width), _height(height), _tiles(tiles), _tileDefs() {
-	_tileDefs.resize(_width * _height);
+const Region kNoRegion = 0xFFFFFFFF;
+
+namespace {
+
+Region findRoot(const std::vector<Region> &regions, unsigned int index) {
+	Region region = regions[index];
+	while (region != kNoRegion && regions[region] != region)
+		region = regions[region];
+	return region;
+}
+
+void mergeRoots(std::vector<Region> &regions, unsigned int a, unsigned int b) {
+	const Region rootA = findRoot(regions, a), rootB = findRoot(regions, b);
+	if (rootA == rootB)
+		return;
+
+	// Always use the lower cell index as label, this keeps the labels
+	// independent of the order in which cells are merged.
+	if (rootA < rootB)
+		regions[rootB] = rootA;
+	else
+		regions[rootA] = rootB;
+}
+
+} // end of anonymous namespace
+
+BaseMap::BaseMap(const TileDatabase &tileDatabase, const std::string &filename, unsigned int width, unsigned int height, const std::vector<Tile> &tiles)
+    : _tileDatabase(tileDatabase), _filename(filename), _width(width), _height(height), _tiles(tiles), _tileDefs(), _sightPlane(), _regions() {
 	assert(_tiles.size() == _width * _height);
 
+	_tileDefs.resize(_width * _height);
+	_sightPlane.resize(_width, _height);
+
 	for (unsigned int i = 0; i < _width * _height; ++i) {
-		_tileDefs[i] = TileDatabase::instance().queryTileDefinition(_tiles[i]);
+		_tileDefs[i] = _tileDatabase.queryTileDefinition(_tiles[i]);
 		assert(_tileDefs[i]);
+
+		if (_tileDefs[i]->getBlocksSlight())
+			_sightPlane.set(i % _width, i / _width);
+	}
+
+	setupRegions();
+}
+
+void BaseMap::setupRegions() {
+	_regions.resize(_width * _height);
+
+	for (unsigned int y = 0; y < _height; ++y) {
+		for (unsigned int x = 0; x < _width; ++x) {
+			const unsigned int index = y * _width + x;
+			if (!isPassable(index)) {
+				_regions[index] = kNoRegion;
+				continue;
+			}
+
+			_regions[index] = index;
+
+			// Monsters can move diagonally, thus all eight neighbours
+			// are connected. Only the neighbours already visited need
+			// to be merged though.
+			if (x > 0 && isPassable(index - 1))
+				mergeRoots(_regions, index, index - 1);
+			if (y > 0) {
+				if (x > 0 && isPassable(index - _width - 1))
+					mergeRoots(_regions, index, index - _width - 1);
+				if (isPassable(index - _width))
+					mergeRoots(_regions, index, index - _width);
+				if (x + 1 < _width && isPassable(index - _width + 1))
+					mergeRoots(_regions, index, index - _width + 1);
+			}
+		}
+	}
+
+	// Flatten the forest, so every lookup is a single access.
+	for (unsigned int i = 0; i < _width * _height; ++i)
+		_regions[i] = findRoot(_regions, i);
+}
+
+Map::Map(boost::shared_ptr<const BaseMap> base)
+    : _base(base), _tileDatabase(base->_tileDatabase), _width(base->_width), _height(base->_height), _changes(), _changed(), _sightPlane(), _sightRevision(0), _regionChanges() {
+}
+
+void Map::syncState(Base::Serializer &s) {
+	assert(s.isSaving() || (_changes.empty() && !_sightRevision && _regionChanges.empty()));
+
+	unsigned int count = static_cast<unsigned int>(_changes.size());
+	s.syncCount(count, 2);
+
+	TileChangeMap::const_iterator change = _changes.begin();
+	for (unsigned int i = 0; i < count; ++i) {
+		unsigned int index = 0;
+		Tile tile = 0;
+		if (s.isSaving()) {
+			index = change->first;
+			tile = change->second._tile;
+			++change;
+		}
+
+		s.syncUint(index);
+		s.syncUint(tile);
+
+		if (s.isLoading()) {
+			if (index >= _width * _height || !_tileDatabase.queryTileDefinition(tile))
+				throw Base::Serializer::Exception("Invalid tile change");
+			setTile(Base::Point(index % _width, index / _width), tile);
+		}
+	}
+
+	// Replaying the changes increases the revision only for the changes,
+	// which affect the sight. The saved revision might be higher though.
+	unsigned int revision = _sightRevision;
+	s.syncUint(revision);
+	if (s.isLoading()) {
+		if (!revision && _sightRevision)
+			throw Base::Serializer::Exception("Invalid sight revision");
+		if (revision && !_sightRevision)
+			_sightPlane = _base->_sightPlane;
+		_sightRevision = revision;
+	}
+}
+
+void Map::setTile(const Base::Point &p, const Tile tile) throw (std::out_of_range) {
+	if (static_cast<unsigned int>(p._x) >= _width || static_cast<unsigned int>(p._y) >= _height)
+		throw std::out_of_range("Tile to change is not inside the map");
+
+	const unsigned int index = p._y * _width + p._x;
+	const TileDefinition *def = _tileDatabase.queryTileDefinition(tile);
+	assert(def);
+
+	const bool wasPassable = isPassable(index);
+	if (_base->_tiles[index] == tile) {
+		if (_changes.erase(index))
+			_changed[index] = false;
+	} else {
+		if (_changed.empty())
+			_changed.resize(_width * _height, false);
+		_changes[index] = TileChange(tile, def);
+		_changed[index] = true;
+	}
+	const bool passable = isPassable(index);
+
+	if (def->getBlocksSlight() != getSightPlane().get(p._x, p._y)) {
+		// The base map's plane is used until the first change.
+		if (!_sightRevision)
+			_sightPlane = _base->_sightPlane;
+		_sightPlane.set(p._x, p._y, def->getBlocksSlight());
+		++_sightRevision;
+	}
+
+	if (passable == wasPassable)
+		return;
+
+	if (passable) {
+		// A new cell can only join regions, this is cheap to
+		// handle with the union-find forest.
+		_regionChanges[index] = index;
+		for (unsigned char dir = 1; dir <= 9; ++dir) {
+			const Base::Point n = p + getDirection(dir);
+			if (n == p || static_cast<unsigned int>(n._x) >= _width || static_cast<unsigned int>(n._y) >= _height)
+				continue;
+
+			const unsigned int nIndex = n._y * _width + n._x;
+			if (isPassable(nIndex))
+				mergeRegions(index, nIndex);
+		}
+	} else {
+		splitRegion(index);
+	}
+}
+
+void Map::mergeRegions(unsigned int a, unsigned int b) {
+	const Region rootA = findRegion(a), rootB = findRegion(b);
+	if (rootA == rootB)
+		return;
+
+	// The lower cell index is the label, like in the base map.
+	if (rootA < rootB)
+		_regionChanges[rootB] = rootA;
+	else
+		_regionChanges[rootA] = rootB;
+}
+
+void Map::splitRegion(unsigned int index) {
+	// Removing a cell might split its region. The union-find forest
+	// can not undo merges, thus we search the parts of the old region
+	// from the removed cell's neighbours. The largest part keeps its
+	// label, only the cells of the other parts are stored with new ones.
+	const Region oldRegion = findRegion(index);
+	_regionChanges[index] = kNoRegion;
+
+	std::vector<bool> visited(_width * _height, false);
+	std::vector<std::vector<unsigned int> > parts;
+	std::deque<unsigned int> queue;
+	const Base::Point p(index % _width, index / _width);
+
+	for (unsigned char dir = 1; dir <= 9; ++dir) {
+		const Base::Point start = p + getDirection(dir);
+		if (start == p || static_cast<unsigned int>(start._x) >= _width || static_cast<unsigned int>(start._y) >= _height)
+			continue;
+
+		const unsigned int startIndex = start._y * _width + start._x;
+		if (visited[startIndex] || !isPassable(startIndex))
+			continue;
+
+		parts.push_back(std::vector<unsigned int>());
+		std::vector<unsigned int> &part = parts.back();
+
+		visited[startIndex] = true;
+		queue.push_back(startIndex);
+
+		while (!queue.empty()) {
+			const unsigned int cur = queue.front();
+			queue.pop_front();
+			part.push_back(cur);
+
+			const Base::Point curPos(cur % _width, cur / _width);
+			for (unsigned char d = 1; d <= 9; ++d) {
+				const Base::Point n = curPos + getDirection(d);
+				if (n == curPos || static_cast<unsigned int>(n._x) >= _width || static_cast<unsigned int>(n._y) >= _height)
+					continue;
+
+				const unsigned int nIndex = n._y * _width + n._x;
+				if (!visited[nIndex] && isPassable(nIndex)) {
+					visited[nIndex] = true;
+					queue.push_back(nIndex);
+				}
+			}
+		}
+	}
+
+	if (parts.empty())
+		return;
+
+	unsigned int kept = 0;
+	for (unsigned int i = 1; i < parts.size(); ++i) {
+		if (parts[i].size() > parts[kept].size())
+			kept = i;
+	}
+
+	for (unsigned int i = 0; i < parts.size(); ++i) {
+		if (i == kept)
+			continue;
+
+		BOOST_FOREACH(unsigned int cell, parts[i])
+			_regionChanges[cell] = parts[i].front();
+	}
+
+	// The cells of the kept part might have reached the old label
+	// through cells of the other parts or the removed cell, those
+	// point to the kept label directly now.
+	const std::vector<unsigned int> &keptPart = parts[kept];
+	Region keptRegion = oldRegion;
+	if (std::find(keptPart.begin(), keptPart.end(), oldRegion) == keptPart.end()) {
+		keptRegion = keptPart.front();
+		_regionChanges[keptRegion] = keptRegion;
+	}
+
+	BOOST_FOREACH(unsigned int cell, keptPart) {
+		if (findRegion(cell) != keptRegion)
+			_regionChanges[cell] = keptRegion;
 	}
 }
 
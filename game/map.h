@@ -22,17 +22,112 @@
 #define GAME_MAP_H
 
 #include "base/geo.h"
+#include "base/bitplane.h"
+#include "base/serializer.h"
 
 #include "tile.h"
+#include "tiledatabase.h"
 
 #include <vector>
+#include <map>
+#include <string>
 #include <stdexcept>
 
+#include <boost/shared_ptr.hpp>
+
 namespace Game {
 
+/**
+ * A region of the map. All cells in the same region are
+ * mutually reachable.
+ */
+typedef unsigned int Region;
+
+/**
+ * The region of cells, which can not be entered.
+ */
+extern const Region kNoRegion;
+
+/**
+ * The map as it was loaded.
+ *
+ * A base map never changes once it is created, thus one object
+ * can be shared by all maps, which are created from it. Next to
+ * the tiles it holds everything derived from them, which is
+ * costly to set up.
+ *
+ * @see Map
+ */
+class BaseMap {
+friend class Map;
+public:
+	/**
+	 * Constructor for a base map.
+	 *
+	 * @param tileDatabase Definitions of all tiles, this must outlive the map.
+	 * @param filename The file the map was loaded from.
+	 * @param width Width of the map.
+	 * @param height Height of the map.
+	 * @param tiles Tiles of the map, line by line.
+	 */
+	BaseMap(const TileDatabase &tileDatabase, const std::string &filename, unsigned int width, unsigned int height, const std::vector<Tile> &tiles);
+
+	/**
+	 * Returns the file the map was loaded from.
+	 *
+	 * @return filename
+	 */
+	const std::string &getFilename() const { return _filename; }
+private:
+	BaseMap(const BaseMap &);
+	BaseMap &operator=(const BaseMap &);
+
+	const TileDatabase &_tileDatabase;
+	const std::string _filename;
+
+	const unsigned int _width, _height;
+	std::vector<Tile> _tiles;
+	std::vector<const TileDefinition *> _tileDefs;
+
+	Base::BitPlane _sightPlane;
+
+	/**
+	 * The regions of all cells. Each cell holds the label of
+	 * its region directly.
+	 */
+	std::vector<Region> _regions;
+
+	bool isPassable(unsigned int index) const {
+		return _tileDefs[index]->getIsWalkable() && !_tileDefs[index]->getIsLiquid();
+	}
+
+	void setupRegions();
+};
+
+/**
+ * A map of a level.
+ *
+ * The map is based upon a shared base map. Only the tiles, which
+ * differ from the base map, are stored in the map itself, next to a
+ * bitmap flagging them. The regions of cells, which differ from the
+ * base map's, are stored the same way. The sight plane is only copied,
+ * once a change affects it.
+ */
 class Map {
 public:
-	Map(unsigned int width, unsigned int height, const std::vector<Tile> &tiles);
+	/**
+	 * Constructor for a map.
+	 *
+	 * @param base The base map to start with.
+	 */
+	Map(boost::shared_ptr<const BaseMap> base);
+
+	/**
+	 * Returns the base map, the map was created from.
+	 *
+	 * @return base map
+	 */
+	const BaseMap &getBase() const { return *_base; }
 
 	/**
 	 * Checks whether the given map tile is walkable.
@@ -68,7 +163,7 @@ public:
 	Tile tileAt(const Base::Point &p) const throw (std::out_of_range) {
 		if (static_cast<unsigned int>(p._x) >= _width || static_cast<unsigned int>(p._y) >= _height)
 			throw std::out_of_range("Tile to look up is not inside the map");
-		return _tiles[p._y * _width + p._x];
+		return lookUpTile(p._y * _width + p._x);
 	}
 
 	/**
@@ -81,7 +176,7 @@ public:
 	Tile tileAt(unsigned int x, unsigned int y) const throw (std::out_of_range) {
 		if (x >= _width || y >= _height)
 			throw std::out_of_range("Tile to look up is not inside the map");
-		return _tiles[y * _width + x];
+		return lookUpTile(y * _width + x);
 	}
 
 	/**
@@ -93,7 +188,7 @@ public:
 	const TileDefinition &tileDefinition(const Base::Point &p) const throw (std::out_of_range) {
 		if (static_cast<unsigned int>(p._x) >= _width || static_cast<unsigned int>(p._y) >= _height)
 			throw std::out_of_range("Tile to look up is not inside the map");
-		return *_tileDefs[p._y * _width + p._x];
+		return *lookUpDefinition(p._y * _width + p._x);
 	}
 
 	/**
@@ -106,9 +201,73 @@ public:
 	const TileDefinition &tileDefinition(unsigned int x, unsigned int y) const throw (std::out_of_range) {
 		if (x >= _width || y >= _height)
 			throw std::out_of_range("Tile to look up is not inside the map");
-		return *_tileDefs[y * _width + x];
+		return *lookUpDefinition(y * _width + x);
+	}
+
+	/**
+	 * Changes the tile at the given position.
+	 *
+	 * @param p Position.
+	 * @param tile New tile type.
+	 */
+	void setTile(const Base::Point &p, const Tile tile) throw (std::out_of_range);
+
+	/**
+	 * Queries the region of the given position.
+	 *
+	 * Regions are made up of all walkable, non liquid
+	 * tiles, which are connected with each other.
+	 *
+	 * @param p Position.
+	 * @return Region of the position (kNoRegion for tiles, which can not be entered).
+	 */
+	Region regionAt(const Base::Point &p) const throw (std::out_of_range) {
+		if (static_cast<unsigned int>(p._x) >= _width || static_cast<unsigned int>(p._y) >= _height)
+			throw std::out_of_range("Tile to look up is not inside the map");
+		return findRegion(p._y * _width + p._x);
 	}
 
+	/**
+	 * Checks whether the given positions are connected
+	 * by walkable, non liquid tiles.
+	 *
+	 * @param a First position.
+	 * @param b Second position.
+	 * @return true if b can be reached from a, false otherwise.
+	 */
+	bool isReachable(const Base::Point &a, const Base::Point &b) const throw (std::out_of_range) {
+		const Region region = regionAt(a);
+		return (region != kNoRegion && region == regionAt(b));
+	}
+
+	/**
+	 * Checks whether the tile at the given position blocks the sight.
+	 *
+	 * @param p Position.
+	 * @return true if it blocks the sight, false otherwise.
+	 */
+	bool blocksSight(const Base::Point &p) const throw (std::out_of_range) {
+		if (static_cast<unsigned int>(p._x) >= _width || static_cast<unsigned int>(p._y) >= _height)
+			throw std::out_of_range("Tile to look up is not inside the map");
+		return getSightPlane().get(p._x, p._y);
+	}
+
+	/**
+	 * Returns a plane, which has a bit set for every tile
+	 * blocking the sight.
+	 *
+	 * @return sight plane.
+	 */
+	const Base::BitPlane &getSightPlane() const { return _sightRevision ? _sightPlane : _base->_sightPlane; }
+
+	/**
+	 * Returns the revision of the sight plane. It is increased
+	 * whenever a tile starts or stops blocking the sight.
+	 *
+	 * @return revision.
+	 */
+	unsigned int getSightRevision() const { return _sightRevision; }
+
 	/**
 	 * Returns the width of the map.
 	 * @return width
@@ -120,10 +279,104 @@ public:
 	 * @return height
 	 */
 	unsigned int getHeight() const { return _height; }
+
+	/**
+	 * Saves or restores the tiles, which differ from the base map.
+	 * When restoring, the map must not be changed yet.
+	 *
+	 * @param s Serializer to use.
+	 */
+	void syncState(Base::Serializer &s);
 private:
-	unsigned int _width, _height;
-	std::vector<Tile> _tiles;
-	std::vector<const TileDefinition *> _tileDefs;
+	const boost::shared_ptr<const BaseMap> _base;
+	const TileDatabase &_tileDatabase;
+
+	const unsigned int _width, _height;
+
+	/**
+	 * A tile, which differs from the base map.
+	 */
+	struct TileChange {
+		Tile _tile;
+		const TileDefinition *_definition;
+
+		TileChange() : _tile(), _definition(0) {}
+		TileChange(Tile tile, const TileDefinition *definition) : _tile(tile), _definition(definition) {}
+	};
+
+	/**
+	 * All tiles, which differ from the base map, indexed by
+	 * their position like y * width + x.
+	 */
+	typedef std::map<unsigned int, TileChange> TileChangeMap;
+	TileChangeMap _changes;
+
+	/**
+	 * Flags every cell, which has an entry in the changes, thus
+	 * unchanged cells are looked up without searching. It is
+	 * empty, until the first tile is changed.
+	 */
+	std::vector<bool> _changed;
+
+	bool isChanged(unsigned int index) const {
+		return !_changed.empty() && _changed[index];
+	}
+
+	Tile lookUpTile(unsigned int index) const {
+		if (isChanged(index))
+			return _changes.find(index)->second._tile;
+		return _base->_tiles[index];
+	}
+
+	const TileDefinition *lookUpDefinition(unsigned int index) const {
+		if (isChanged(index))
+			return _changes.find(index)->second._definition;
+		return _base->_tileDefs[index];
+	}
+
+	/**
+	 * The sight plane of the map. It is only used, when the
+	 * sight revision is not 0, the base map's plane is used
+	 * otherwise.
+	 */
+	Base::BitPlane _sightPlane;
+	unsigned int _sightRevision;
+
+	/**
+	 * The union-find forest of all regions. Each cell points to
+	 * its parent cell; the root cell of a tree is the label of
+	 * the region. Only the parents, which differ from the base
+	 * map's labels, are stored here.
+	 */
+	typedef std::map<unsigned int, Region> RegionChangeMap;
+	RegionChangeMap _regionChanges;
+
+	bool isPassable(unsigned int index) const {
+		const TileDefinition *def = lookUpDefinition(index);
+		return def->getIsWalkable() && !def->getIsLiquid();
+	}
+
+	Region parentOf(unsigned int index) const {
+		const RegionChangeMap::const_iterator i = _regionChanges.find(index);
+		return (i != _regionChanges.end()) ? i->second : _base->_regions[index];
+	}
+
+	Region findRegion(unsigned int index) const {
+		if (_regionChanges.empty())
+			return _base->_regions[index];
+
+		Region region = parentOf(index);
+		while (region != kNoRegion) {
+			const Region parent = parentOf(region);
+			if (parent == region)
+				break;
+			region = parent;
+		}
+		return region;
+	}
+
+	void mergeRegions(unsigned int a, unsigned int b);
+	void splitRegion(unsigned int index);
 };
 
 } // end of namespace Game
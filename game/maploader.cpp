@@ -19,7 +19,6 @@
  */
 
 #include "maploader.h"
-#include "tiledatabase.h"
 
 #include <fstream>
 #include <sstream>
@@ -28,8 +27,8 @@
 
 namespace Game {
 
-MapLoader::MapLoader(const std::string &filename)
-    : _filename(filename), _lines() {
+MapLoader::MapLoader(const std::string &filename, const TileDatabase &tileDatabase)
+    : _filename(filename), _tileDatabase(tileDatabase), _lines() {
 	std::ifstream in(filename.c_str());
 
 	while (!in.eof()) {
@@ -39,13 +38,13 @@ MapLoader::MapLoader(const std::string &filename)
 	}
 }
 
-Map *MapLoader::load() throw (Base::NonRecoverableException) {
+BaseMap *MapLoader::load() throw (Base::NonRecoverableException) {
 	if (_lines.empty() || _lines.size() < 3)
 		throwError("Contains too few lines", 0);
 
 	int lineCount = 2;
 
-	TileDatabase &tdb = TileDatabase::instance();
+	const TileDatabase &tdb = _tileDatabase;
 	unsigned int w = -1, h = -1;
    
 	try {
@@ -100,7 +99,7 @@ Map *MapLoader::load() throw (Base::NonRecoverableException) {
 		}
 	}
 
-	return new Map(w, h, tiles);
+	return new BaseMap(_tileDatabase, _filename, w, h, tiles);
 }
 
 void MapLoader::throwError(const std::string &error, int line) throw (Base::NonRecoverableException) {
@@ -22,6 +22,7 @@
 #define GAME_MAPLOADER_H
 
 #include "map.h"
+#include "tiledatabase.h"
 
 #include "base/exception.h"
 
@@ -40,17 +41,19 @@ public:
 	 * filename.
 	 *
 	 * @param filename Filename of the map
+	 * @param tileDatabase Definitions of all tiles.
 	 */
-	MapLoader(const std::string &filename);
+	MapLoader(const std::string &filename, const TileDatabase &tileDatabase);
 
 	/**
 	 * Load the map.
 	 *
-	 * @return A pointer to a new map object.
+	 * @return A pointer to a new base map object.
 	 */
-	Map *load() throw (Base::NonRecoverableException);
+	BaseMap *load() throw (Base::NonRecoverableException);
 private:
 	const std::string _filename;
+	const TileDatabase &_tileDatabase;
 
 	void throwError(const std::string &error, int line) throw (Base::NonRecoverableException);
 
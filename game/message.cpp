@@ -0,0 +1,125 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "message.h"
+
+#include <cassert>
+
+namespace Game {
+
+namespace {
+
+/**
+ * The texts of all message templates.
+ *
+ * A "%m" is replaced by the name of the monster type passed as
+ * next argument, a "%t" by the name of the tile passed as next
+ * argument.
+ */
+const char * const kMessageTemplates[kMsgTemplateCount] = {
+	"You die...",
+	"You drown.",
+	"You seem bored.",
+	"You yawn.",
+	"You nearly fall asleep.",
+	"The %m seems unsure what to do next.",
+	"The %m seems to be watching you.",
+	"The %m makes you nervous.",
+	"The %m seems to be aware of your presence.",
+	"The %m kills you!",
+	"You kill the %m!",
+	"The %m is killed by the %m!",
+	"The %m drowned.",
+	"The %m hits you!",
+	"The %m hits you! Somehow the attack does not cause any damage.",
+	"You hit the %m!",
+	"You hit the %m! Somehow the attack does not cause any damage.",
+	"You miss!",
+	"The %m misses!",
+	"You are examining the environment now.",
+	"You see here a %m.",
+	"This is just a simple %t.",
+	"Where do you want to travel to?",
+	"You do not know a way there."
+};
+
+} // end of anonymous namespace
+
+void formatMessage(const Definitions &defs, const Message &msg, std::string &out) {
+	assert(msg._template < kMsgTemplateCount);
+
+	const unsigned int *arg = msg._args;
+	for (const char *text = kMessageTemplates[msg._template]; *text; ++text) {
+		if (*text != '%') {
+			out += *text;
+			continue;
+		}
+
+		assert(arg < msg._args + 2);
+		switch (*++text) {
+		case 'm':
+			out += defs.getMonsterDatabase().getMonsterName(*arg++);
+			break;
+
+		case 't': {
+			const TileDefinition *def = defs.getTileDatabase().queryTileDefinition(*arg++);
+			assert(def);
+			out += def->getName();
+			} break;
+
+		default:
+			assert(false);
+			break;
+		}
+	}
+}
+
+bool isValidMessage(const Definitions &defs, const Message &msg) {
+	if (msg._template >= kMsgTemplateCount)
+		return false;
+
+	const unsigned int *arg = msg._args;
+	for (const char *text = kMessageTemplates[msg._template]; *text; ++text) {
+		if (*text != '%')
+			continue;
+		if (arg == msg._args + 2)
+			return false;
+
+		switch (*++text) {
+		case 'm':
+			if (*arg++ >= defs.getMonsterDatabase().getMonsterTypeCount())
+				return false;
+			break;
+
+		case 't':
+			if (*arg++ >= defs.getTileDatabase().getTileCount())
+				return false;
+			break;
+
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // end of namespace Game
+
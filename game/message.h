@@ -0,0 +1,118 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GAME_MESSAGE_H
+#define GAME_MESSAGE_H
+
+#include "monsterdefinition.h"
+#include "tile.h"
+#include "definitions.h"
+
+#include <string>
+
+namespace Game {
+
+/**
+ * The templates of all messages shown to the player.
+ *
+ * @see formatMessage
+ */
+enum MessageTemplate {
+	kMsgYouDie,
+	kMsgYouDrown,
+	kMsgYouAreBored,
+	kMsgYouYawn,
+	kMsgYouNearlyFallAsleep,
+	kMsgMonsterIsUnsure,
+	kMsgMonsterWatchesYou,
+	kMsgMonsterMakesYouNervous,
+	kMsgMonsterIsAware,
+	kMsgMonsterKillsYou,
+	kMsgYouKillMonster,
+	kMsgMonsterIsKilled,
+	kMsgMonsterDrowned,
+	kMsgMonsterHitsYou,
+	kMsgMonsterHitsYouNoDamage,
+	kMsgYouHitMonster,
+	kMsgYouHitMonsterNoDamage,
+	kMsgYouMiss,
+	kMsgMonsterMisses,
+	kMsgExamine,
+	kMsgExamineMonster,
+	kMsgExamineTile,
+	kMsgTravel,
+	kMsgTravelNoPath,
+
+	kMsgTemplateCount
+};
+
+/**
+ * A message to the player.
+ *
+ * It only stores the template and its arguments, the
+ * actual text is created when the message is shown.
+ */
+struct Message {
+	/**
+	 * The template of the message.
+	 */
+	MessageTemplate _template;
+
+	/**
+	 * The arguments of the message. Depending on the template
+	 * these are monster types or tiles.
+	 */
+	unsigned int _args[2];
+
+	Message() : _template(kMsgYouDie) { _args[0] = _args[1] = 0; }
+	Message(MessageTemplate msg, unsigned int arg0 = 0, unsigned int arg1 = 0) : _template(msg) {
+		_args[0] = arg0;
+		_args[1] = arg1;
+	}
+};
+
+/**
+ * Formats the text of a message.
+ *
+ * The text is appended to the given string, thus the
+ * string's memory can be reused for every message.
+ *
+ * @param defs Definitions to look up names in.
+ * @param msg Message to format.
+ * @param out Where to append the text.
+ */
+void formatMessage(const Definitions &defs, const Message &msg, std::string &out);
+
+/**
+ * Checks whether a message can be formatted, that is whether
+ * all of its arguments refer to defined monster types or tiles.
+ *
+ * This is meant for messages restored from a snapshot.
+ *
+ * @param defs Definitions to check the arguments against.
+ * @param msg Message to check.
+ * @return true if valid, false otherwise.
+ */
+bool isValidMessage(const Definitions &defs, const Message &msg);
+
+} // end of namespace Game
+
+#endif
+
@@ -27,12 +27,14 @@ const MonsterType kMonsterPlayer = 0;
 const MonsterID kPlayerMonsterID = 0;
 const MonsterID kInvalidMonsterID = 0xFFFFFFFF;
 
-namespace {
-MonsterID g_nextMonsterID = kPlayerMonsterID + 1;
-} // end of anonymous namespace
-
-MonsterID createNewMonsterID() {
-	return g_nextMonsterID++;
+void Monster::syncState(Base::Serializer &s) {
+	s.syncUint(_type);
+	s.syncPoint(_pos);
+	s.syncInt(_curHealth);
+	s.syncInt(_maxHealth);
+	for (int i = 0; i < kAttribMaxTypes; ++i)
+		s.syncByte(_attrib[i]);
+	s.syncByte(_speed);
 }
 
 } // end of namespace Game
@@ -24,6 +24,7 @@
 #include "monsterdefinition.h"
 
 #include "base/geo.h"
+#include "base/serializer.h"
 
 #include <algorithm>
 
@@ -33,10 +34,18 @@ typedef unsigned int MonsterID;
 extern const MonsterID kPlayerMonsterID;
 extern const MonsterID kInvalidMonsterID;
 
-MonsterID createNewMonsterID();
-
 class Monster {
 public:
+	/**
+	 * Constructor for a monster, which is restored from a
+	 * snapshot afterwards.
+	 *
+	 * @see syncState
+	 */
+	Monster() : _type(0), _pos(), _curHealth(0), _maxHealth(0), _speed(0) {
+		std::fill(_attrib, _attrib + kAttribMaxTypes, 0);
+	}
+
 	Monster(MonsterType type, unsigned char wis, unsigned char dex, unsigned char agi, unsigned char str, int health, unsigned char speed, unsigned int x, unsigned int y)
 	    : _type(type), _pos(x, y), _curHealth(health), _maxHealth(health), _speed(speed) {
 		_attrib[kAttribWisdom] = wis;
@@ -144,6 +153,13 @@ public:
 	 * @return speed in ticks.
 	 */
 	unsigned char getSpeed() const { return _speed; }
+
+	/**
+	 * Saves or restores the monster.
+	 *
+	 * @param s Serializer to use.
+	 */
+	void syncState(Base::Serializer &s);
 private:
 	MonsterType _type;
 
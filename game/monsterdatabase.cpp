@@ -44,17 +44,31 @@ void MonsterDatabase::load(const std::string &filename) throw (Base::NonRecovera
 	}
 }
 
-Monster *MonsterDatabase::createNewMonster(const MonsterType type) const {
+Monster *MonsterDatabase::createNewMonster(const MonsterType type, Base::RNG &rng) const {
 	MonsterDefMap::const_iterator i = _monsterDefs.find(type);
 	if (i == _monsterDefs.end())
 		return 0;
 
 	const MonsterDefinition &def = i->second;
-	const unsigned char wis = Base::rndValueRange(def.getDefaultAttribs(kAttribWisdom));
-	const unsigned char dex = Base::rndValueRange(def.getDefaultAttribs(kAttribDexterity));
-	const unsigned char agi = Base::rndValueRange(def.getDefaultAttribs(kAttribAgility));
-	const unsigned char str = Base::rndValueRange(def.getDefaultAttribs(kAttribStrength));
-	const int hp = Base::rndValueRange(def.getDefaultHitPoints());
+
+	// Roll all attributes and the hit points at once.
+	unsigned int min[kAttribMaxTypes + 1], max[kAttribMaxTypes + 1];
+	for (int attrib = 0; attrib < kAttribMaxTypes; ++attrib) {
+		const Base::ByteRange &range = def.getDefaultAttribs(static_cast<Attribute>(attrib));
+		min[attrib] = range.getMin();
+		max[attrib] = range.getMax();
+	}
+	min[kAttribMaxTypes] = def.getDefaultHitPoints().getMin();
+	max[kAttribMaxTypes] = def.getDefaultHitPoints().getMax();
+
+	unsigned int values[kAttribMaxTypes + 1];
+	rng.fillRanges(values, min, max, kAttribMaxTypes + 1);
+
+	const unsigned char wis = static_cast<unsigned char>(values[kAttribWisdom]);
+	const unsigned char dex = static_cast<unsigned char>(values[kAttribDexterity]);
+	const unsigned char agi = static_cast<unsigned char>(values[kAttribAgility]);
+	const unsigned char str = static_cast<unsigned char>(values[kAttribStrength]);
+	const int hp = values[kAttribMaxTypes];
 
 	return new Monster(type, wis, dex, agi, str, hp, def.getDefaultSpeed(), 0, 0);
 }
@@ -75,21 +89,9 @@ MonsterType MonsterDatabase::queryMonsterType(const std::string &name) const {
 		return i->second;
 }
 
-MonsterDatabase &MonsterDatabase::instance() {
-	if (!_instance)
-		_instance = new MonsterDatabase();
-	return *_instance;
-}
-
-void MonsterDatabase::destroy() {
-	delete _instance;
-	_instance = 0;
-}
-
 MonsterDatabase::MonsterDatabase()
     : _nextMonsterType(0), _monsterDefs(), _monsterNames() {
 }
 
-MonsterDatabase *MonsterDatabase::_instance = 0;
 } // end of namespace Base
 
@@ -25,6 +25,7 @@
 #include "monster.h"
 
 #include "base/exception.h"
+#include "base/rnd.h"
 
 #include <map>
 
@@ -38,6 +39,8 @@ namespace Game {
  */
 class MonsterDatabase {
 public:
+	MonsterDatabase();
+
 	/**
 	 * Loads the monster database from a file.
 	 *
@@ -51,8 +54,9 @@ public:
 	 * Creates a monster of the given type.
 	 *
 	 * @param type Type of the monster.
+	 * @param rng Random number generator to roll the attributes with.
 	 */
-	Monster *createNewMonster(const MonsterType type) const;
+	Monster *createNewMonster(const MonsterType type, Base::RNG &rng) const;
 
 	/**
 	 * Queries the type of a monster with the given name.
@@ -73,20 +77,7 @@ public:
 	 * Queries the number of different monster types.
 	 */
 	unsigned int getMonsterTypeCount() const { return _nextMonsterType; }
-
-	/**
-	 * Queries the global monster database
-	 */
-	static MonsterDatabase &instance();
-
-	/**
-	 * Destroies the global monster database
-	 */
-	static void destroy();
 private:
-	MonsterDatabase();
-	static MonsterDatabase *_instance;
-
 	MonsterType _nextMonsterType;
 	typedef std::map<MonsterType, MonsterDefinition> MonsterDefMap;
 	MonsterDefMap _monsterDefs;
@@ -95,8 +86,6 @@ private:
 	MonsterNameMap _monsterNames;
 };
 
-#define g_monsterDatabase Game::MonsterDatabase::instance()
-
 } // end of namespace Game
 
 #endif
@@ -25,8 +25,6 @@
 
 namespace Game {
 
-TileDatabase *TileDatabase::_instance = 0;
-
 TileDatabase::TileDatabase()
     : _nextTileID(0), _tileDefinitions() {
 }
@@ -68,16 +66,5 @@ Tile TileDatabase::queryTile(const char glyph) const {
 	return getTileCount();
 }
 
-TileDatabase &TileDatabase::instance() {
-	if (!_instance)
-		_instance = new TileDatabase();
-	return *_instance;
-}
-
-void TileDatabase::destroy() {
-	delete _instance;
-	_instance = 0;
-}
-
 } // end of namespace Game
 
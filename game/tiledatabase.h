@@ -31,6 +31,8 @@ namespace Game {
 
 class TileDatabase {
 public:
+	TileDatabase();
+
 	/**
 	 * Loads the tile database from a file.
 	 *
@@ -67,21 +69,7 @@ public:
 	 * @return Tile type (getTileCount() in case of an error).
 	 */
 	Tile queryTile(const char glyph) const;
-
-	/**
-	 * Queries the global tile database instance.
-	 */
-	static TileDatabase &instance();
-
-	/**
-	 * Destroies the global tile database instance.
-	 */
-	static void destroy();
 private:
-	TileDatabase();
-
-	static TileDatabase *_instance;
-
 	Tile _nextTileID;
 	typedef std::map<Tile, TileDefinition> TileDefMap;
 	TileDefMap _tileDefinitions;
@@ -21,10 +21,25 @@
 #ifndef GUI_DEFS_H
 #define GUI_DEFS_H
 
-#include <ncurses.h>
+#include <stdint.h>
 
 namespace GUI {
 
+/**
+ * The data of a single character cell.
+ *
+ * The lowest byte is the character, the byte above it is the
+ * color pair and the upper bits are the attributes.
+ *
+ * @see Window::getCharData
+ */
+typedef uint32_t CharData;
+
+const CharData kCharDataChar = 0x000000FF;
+const CharData kCharDataColor = 0x0000FF00;
+const CharData kCharDataAttribs = 0xFFFF0000;
+const unsigned int kCharDataColorShift = 8;
+
 enum ColorPair {
 	kWhiteOnBlack = 1,
 	kRedOnBlack,
@@ -35,25 +50,29 @@ enum ColorPair {
 	kCyanOnBlack
 };
 
-#define kUpperLeftEdge ACS_ULCORNER
-#define kUpperRightEdge ACS_URCORNER
-#define kLowerLeftEdge ACS_LLCORNER
-#define kLowerRightEdge ACS_LRCORNER
-#define kCross ACS_PLUS
-#define kTeePointRight ACS_LTEE
-#define kTeePointLeft ACS_RTEE
-#define kTeePointUp ACS_BTEE
-#define kTeePointDown ACS_TTEE
-#define kVerticalLine ACS_VLINE
-#define kHorizontalLine ACS_HLINE
-#define kDiamond ACS_DIAMOND
+// The line drawing glyphs use the VT100 special graphics
+// character set. The backends take care of mapping them
+// to what the terminal supports.
+#define kUpperLeftEdge (kAttribAltCharset | 'l')
+#define kUpperRightEdge (kAttribAltCharset | 'k')
+#define kLowerLeftEdge (kAttribAltCharset | 'm')
+#define kLowerRightEdge (kAttribAltCharset | 'j')
+#define kCross (kAttribAltCharset | 'n')
+#define kTeePointRight (kAttribAltCharset | 't')
+#define kTeePointLeft (kAttribAltCharset | 'u')
+#define kTeePointUp (kAttribAltCharset | 'v')
+#define kTeePointDown (kAttribAltCharset | 'w')
+#define kVerticalLine (kAttribAltCharset | 'x')
+#define kHorizontalLine (kAttribAltCharset | 'q')
+#define kDiamond (kAttribAltCharset | '`')
 
 enum Attributes {
-	kAttribNormal = A_NORMAL,
-	kAttribUnderline = A_UNDERLINE,
-	kAttribBold = A_BOLD,
-	kAttribReverse = A_REVERSE,
-	kAttribDim = A_DIM
+	kAttribNormal = 0,
+	kAttribUnderline = 1 << 17,
+	kAttribReverse = 1 << 18,
+	kAttribDim = 1 << 20,
+	kAttribBold = 1 << 21,
+	kAttribAltCharset = 1 << 22
 };
 
 enum Keys {
@@ -66,7 +85,7 @@ enum Keys {
 	kKeyKeypad7 = '7',
 	kKeyKeypad8 = '8',
 	kKeyKeypad9 = '9',
-	kKeyBackspace = KEY_BACKSPACE,
+	kKeyBackspace = 0x107,
 	kKeyReturn = 10,
 	kKeyEscape = 27
 };
@@ -83,7 +102,9 @@ enum Input {
 	kInputDir7,
 	kInputDir8,
 	kInputDir9,
-	kInputExamine
+	kInputExamine,
+	kInputTravel,
+	kInputRest
 };
 
 } // end of namespace GUI
@@ -0,0 +1,542 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "ansibackend.h"
+#include "window.h"
+#include "input.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <boost/lexical_cast.hpp>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+namespace GUI {
+namespace Intern {
+
+namespace {
+
+/**
+ * The color codes of the foreground color of all color pairs.
+ */
+const char * const kForegroundCodes[] = {
+	"39",
+	"37", // kWhiteOnBlack
+	"31", // kRedOnBlack
+	"32", // kGreenOnBlack
+	"33", // kYellowOnBlack
+	"34", // kBlueOnBlack
+	"35", // kMagentaOnBlack
+	"36"  // kCyanOnBlack
+};
+
+struct SGRFlag {
+	CharData _attrib;
+	const char *_code;
+};
+
+const SGRFlag kSGRFlags[] = {
+	{ kAttribBold, "1" },
+	{ kAttribDim, "2" },
+	{ kAttribUnderline, "4" },
+	{ kAttribReverse, "7" }
+};
+
+/**
+ * Creates a control sequence with a numeric parameter. The
+ * parameter is left out, when it is the default of 1.
+ */
+std::string csi(unsigned int param, char command) {
+	if (param == 1)
+		return std::string("\033[") + command;
+	else
+		return "\033[" + boost::lexical_cast<std::string>(param) + command;
+}
+
+/**
+ * Creates an absolute cursor movement.
+ */
+std::string cursorPosition(unsigned int x, unsigned int y) {
+	if (x == 0)
+		return (y == 0) ? "\033[H" : csi(y + 1, 'H');
+	else
+		return "\033[" + boost::lexical_cast<std::string>(y + 1) + ';' + boost::lexical_cast<std::string>(x + 1) + 'H';
+}
+
+/**
+ * The look of blank cells after clearing or scrolling.
+ */
+const CharData kBlankCell = Window::getCharData(' ', kWhiteOnBlack);
+
+} // end of anonymous namespace
+
+const CharData AnsiBackend::kUnknownCell;
+const CharData AnsiBackend::kSGRMask;
+volatile sig_atomic_t AnsiBackend::_resized = 0;
+int AnsiBackend::_wakeupPipe[2] = { -1, -1 };
+
+AnsiBackend::AnsiBackend()
+    : _in(STDIN_FILENO), _out(STDOUT_FILENO), _oldTermios(), _sink(0), _width(0), _height(0), _front(), _back(),
+      _curX(0), _curY(0), _termX(-1), _termY(-1), _termAttribs(0), _termAttribsKnown(false), _termAltCharset(false),
+      _output(), _frames(0), _totalBytes(0), _frameBytes(0) {
+	if (tcgetattr(_in, &_oldTermios) != 0)
+		throw std::string("The standard input is no terminal");
+
+	termios mode = _oldTermios;
+	mode.c_lflag &= static_cast<tcflag_t>(~(ICANON | ECHO));
+	mode.c_cc[VMIN] = 1;
+	mode.c_cc[VTIME] = 0;
+	tcsetattr(_in, TCSAFLUSH, &mode);
+
+	// The pipe is used to wake up a blocking poll, when the
+	// terminal is resized or the poll is interrupted.
+	if (pipe(_wakeupPipe) != 0) {
+		tcsetattr(_in, TCSAFLUSH, &_oldTermios);
+		throw std::string("Could not create the wakeup pipe");
+	}
+
+	struct sigaction action;
+	std::memset(&action, 0, sizeof(action));
+	action.sa_handler = &AnsiBackend::handleResize;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGWINCH, &action, 0);
+
+	queryTerminalSize();
+
+	// Switch to the alternate screen and setup the VT100 line
+	// drawing characters as G1 character set.
+	_output = "\033[?1049h\033)0";
+	clear();
+}
+
+AnsiBackend::AnsiBackend(std::string &output, unsigned int w, unsigned int h)
+    : _in(-1), _out(-1), _oldTermios(), _sink(&output), _width(0), _height(0), _front(), _back(),
+      _curX(0), _curY(0), _termX(-1), _termY(-1), _termAttribs(0), _termAttribsKnown(false), _termAltCharset(false),
+      _output(), _frames(0), _totalBytes(0), _frameBytes(0) {
+	setSize(w, h);
+
+	_output = "\033[?1049h\033)0";
+	clear();
+}
+
+AnsiBackend::~AnsiBackend() {
+	_output += "\033[0m";
+	if (_termAltCharset)
+		_output += '\017';
+	_output += "\033[?1049l";
+	write(_output);
+
+	if (_sink)
+		return;
+
+	signal(SIGWINCH, SIG_DFL);
+	tcsetattr(_in, TCSAFLUSH, &_oldTermios);
+
+	close(_wakeupPipe[0]);
+	close(_wakeupPipe[1]);
+	_wakeupPipe[0] = _wakeupPipe[1] = -1;
+}
+
+void AnsiBackend::handleResize(int) {
+	_resized = 1;
+	wakeUp();
+}
+
+void AnsiBackend::wakeUp() {
+	const char wakeup = 0;
+	if (::write(_wakeupPipe[1], &wakeup, 1) < 0) {
+		// The pipe being full is just fine, the poll
+		// will wake up in that case anyway.
+	}
+}
+
+void AnsiBackend::updateSize() {
+	if (!_sink)
+		queryTerminalSize();
+}
+
+void AnsiBackend::queryTerminalSize() {
+	winsize size;
+	if (ioctl(_out, TIOCGWINSZ, &size) == 0 && size.ws_col && size.ws_row)
+		setSize(size.ws_col, size.ws_row);
+	else
+		setSize(80, 24);
+}
+
+void AnsiBackend::setSize(unsigned int w, unsigned int h) {
+	_width = w;
+	_height = h;
+
+	_front.assign(_width * _height, kUnknownCell);
+	_back.assign(_width * _height, kBlankCell);
+	_curX = std::min(_curX, _width - 1);
+	_curY = std::min(_curY, _height - 1);
+	_termX = _termY = -1;
+}
+
+void AnsiBackend::clear() {
+	// Clearing fills the screen with the current background color
+	// on all common terminals, thus all cells are known afterwards.
+	setAttribs(kBlankCell);
+	_output += "\033[H\033[2J";
+	_termX = _termY = 0;
+
+	std::fill(_front.begin(), _front.end(), kBlankCell);
+	std::fill(_back.begin(), _back.end(), kBlankCell);
+}
+
+void AnsiBackend::putRun(unsigned int x, unsigned int y, const CharData *data, unsigned int length) {
+	if (y >= _height || x >= _width)
+		return;
+	length = std::min(length, _width - x);
+
+	// Characters without a color use the default color pair of
+	// the screen.
+	CharData *dst = &_back[y * _width + x];
+	for (unsigned int i = 0; i < length; ++i) {
+		dst[i] = data[i];
+		if (!(dst[i] & kCharDataColor))
+			dst[i] |= kBlankCell & kCharDataColor;
+	}
+}
+
+void AnsiBackend::setCursor(unsigned int x, unsigned int y) {
+	_curX = std::min(x, _width - 1);
+	_curY = std::min(y, _height - 1);
+}
+
+void AnsiBackend::flush() {
+	scrollLines();
+
+	for (unsigned int y = 0; y < _height; ++y) {
+		if (isLineEqual(y, y))
+			continue;
+
+		scrollColumns(y);
+
+		const unsigned int offset = y * _width;
+		for (unsigned int x = 0; x < _width; ++x) {
+			if (_back[offset + x] != _front[offset + x])
+				putCell(x, y);
+		}
+	}
+
+	moveTo(_curX, _curY);
+
+	_frameBytes = static_cast<unsigned int>(_output.size());
+	_totalBytes += _frameBytes;
+	++_frames;
+
+	write(_output);
+	_output.clear();
+}
+
+int AnsiBackend::poll() {
+	return readKey(-1);
+}
+
+int AnsiBackend::pollPending() {
+	return readKey(0);
+}
+
+int AnsiBackend::readKey(int timeout) {
+	while (true) {
+		if (_resized) {
+			_resized = 0;
+			return kNotifyResize;
+		}
+
+		pollfd fds[2] = {
+			{ _in, POLLIN, 0 },
+			{ _wakeupPipe[0], POLLIN, 0 }
+		};
+
+		const int ready = ::poll(fds, 2, timeout);
+		if (ready < 0) {
+			if (errno == EINTR)
+				continue;
+			return kNotifyError;
+		} else if (!ready) {
+			return kNotifyNoInput;
+		}
+
+		if (fds[1].revents) {
+			char wakeup;
+			if (read(_wakeupPipe[0], &wakeup, 1) == 1 && !_resized)
+				return kNotifyError;
+			continue;
+		}
+
+		unsigned char input = 0;
+		const ssize_t result = read(_in, &input, 1);
+		if (result < 0 && errno == EINTR)
+			continue;
+		else if (result <= 0)
+			return kNotifyError;
+
+		if (input == kKeyEscape) {
+			// A single escape is the escape key, everything
+			// else is an escape sequence of a key we do not
+			// know about.
+			pollfd fd = { _in, POLLIN, 0 };
+			if (::poll(&fd, 1, 10) <= 0 || read(_in, &input, 1) != 1)
+				return kKeyEscape;
+
+			if (input == '[' || input == 'O') {
+				do {
+					if (::poll(&fd, 1, 10) <= 0 || read(_in, &input, 1) != 1)
+						break;
+				} while (input < 0x40 || input > 0x7E);
+			}
+
+			return kNotifyError;
+		} else if (input == 127 || input == '\b') {
+			return kKeyBackspace;
+		}
+
+		return input;
+	}
+}
+
+void AnsiBackend::write(const std::string &data) {
+	if (_sink) {
+		*_sink += data;
+		return;
+	}
+
+	const char *src = data.c_str();
+	size_t left = data.size();
+
+	while (left) {
+		const ssize_t written = ::write(_out, src, left);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		src += written;
+		left -= static_cast<size_t>(written);
+	}
+}
+
+bool AnsiBackend::isLineEqual(unsigned int a, unsigned int b) const {
+	return std::equal(_back.begin() + a * _width, _back.begin() + (a + 1) * _width, _front.begin() + b * _width);
+}
+
+void AnsiBackend::scrollLines() {
+	unsigned int top = 0, bottom = _height - 1;
+	while (top < _height && isLineEqual(top, top))
+		++top;
+	if (top == _height)
+		return;
+	while (isLineEqual(bottom, bottom))
+		--bottom;
+
+	if (bottom - top < 2)
+		return;
+
+	// Check whether the changed lines are the lines, which were
+	// shown before, shifted by one line.
+	unsigned int equal = 0, up = 0, down = 0;
+	for (unsigned int y = top; y <= bottom; ++y) {
+		if (isLineEqual(y, y))
+			++equal;
+		if (y < bottom && isLineEqual(y, y + 1))
+			++up;
+		if (y > top && isLineEqual(y, y - 1))
+			++down;
+	}
+
+	if (up <= equal + 1 && down <= equal + 1)
+		return;
+
+	setAttribs(kBlankCell);
+	_output += "\033[" + boost::lexical_cast<std::string>(top + 1) + ';' + boost::lexical_cast<std::string>(bottom + 1) + 'r';
+
+	CellBuffer::iterator first = _front.begin() + top * _width, last = _front.begin() + (bottom + 1) * _width;
+	if (up >= down) {
+		_output += cursorPosition(0, bottom) + "\033D";
+		std::copy(first + _width, last, first);
+		std::fill(last - _width, last, kBlankCell);
+	} else {
+		_output += cursorPosition(0, top) + "\033M";
+		std::copy_backward(first, last - _width, last);
+		std::fill(first, first + _width, kBlankCell);
+	}
+
+	// Resetting the scroll region moves the cursor home.
+	_output += "\033[r";
+	_termX = _termY = 0;
+}
+
+void AnsiBackend::scrollColumns(unsigned int y) {
+	CellBuffer::iterator front = _front.begin() + y * _width;
+	const CellBuffer::const_iterator back = _back.begin() + y * _width;
+
+	unsigned int equal = 0, left = 0, right = 0;
+	for (unsigned int x = 0; x < _width; ++x) {
+		if (back[x] == front[x])
+			++equal;
+		if (x + 1 < _width && back[x] == front[x + 1])
+			++left;
+		if (x > 0 && back[x] == front[x - 1])
+			++right;
+	}
+
+	// Deleting or inserting a character needs a few bytes,
+	// thus it only pays off when more cells are saved.
+	const unsigned int minSaved = 8;
+	if (left <= equal + minSaved && right <= equal + minSaved)
+		return;
+
+	moveTo(0, y);
+	if (left >= right) {
+		_output += "\033[P";
+		std::copy(front + 1, front + _width, front);
+		front[_width - 1] = kUnknownCell;
+	} else {
+		_output += "\033[@";
+		std::copy_backward(front, front + _width - 1, front + _width);
+		front[0] = kUnknownCell;
+	}
+}
+
+void AnsiBackend::moveTo(unsigned int x, unsigned int y) {
+	const int newX = static_cast<int>(x), newY = static_cast<int>(y);
+	if (_termX == newX && _termY == newY)
+		return;
+
+	std::string best = cursorPosition(x, y);
+
+	if (_termY == newY && _termX >= 0) {
+		if (newX > _termX) {
+			const unsigned int gap = newX - _termX;
+			const std::string forward = csi(gap, 'C');
+			if (forward.size() < best.size())
+				best = forward;
+
+			// Writing the cells again might be even shorter than
+			// moving the cursor, but only when the cells need no
+			// attribute or character set change.
+			if (gap <= kMaxRewrite && gap < best.size() && _termAttribsKnown) {
+				std::string rewrite;
+				for (unsigned int i = _termX; i < x; ++i) {
+					const CharData ch = _front[y * _width + i];
+					if (ch == kUnknownCell || (ch & kSGRMask) != _termAttribs || ((ch & kAttribAltCharset) != 0) != _termAltCharset)
+						break;
+					rewrite += static_cast<char>(ch & kCharDataChar);
+				}
+
+				if (rewrite.size() == gap)
+					best = rewrite;
+			}
+		} else {
+			const unsigned int gap = _termX - newX;
+			std::string backward = (gap <= 3) ? std::string(gap, '\b') : csi(gap, 'D');
+			if (backward.size() < best.size())
+				best = backward;
+
+			const std::string carriageReturn = (x == 0) ? "\r" : '\r' + csi(x, 'C');
+			if (carriageReturn.size() < best.size())
+				best = carriageReturn;
+		}
+	} else if (_termX >= 0 && _termY >= 0) {
+		const std::string vertical = (newY > _termY) ? csi(newY - _termY, 'B') : csi(_termY - newY, 'A');
+
+		if (newX == _termX && vertical.size() < best.size())
+			best = vertical;
+		else if (x == 0 && vertical.size() + 1 < best.size())
+			best = '\r' + vertical;
+	}
+
+	_output += best;
+	_termX = newX;
+	_termY = newY;
+}
+
+void AnsiBackend::setAttribs(CharData attribs) {
+	attribs &= kSGRMask;
+	if (_termAttribsKnown && _termAttribs == attribs)
+		return;
+
+	// Attributes can only be switched off by resetting all of them.
+	CharData old = _termAttribs;
+	std::string codes;
+	if (!_termAttribsKnown || (old & ~attribs & ~kCharDataColor)) {
+		codes = "0";
+		old = 0;
+	}
+
+	for (size_t i = 0; i < sizeof(kSGRFlags) / sizeof(kSGRFlags[0]); ++i) {
+		if ((attribs & kSGRFlags[i]._attrib) && !(old & kSGRFlags[i]._attrib)) {
+			if (!codes.empty())
+				codes += ';';
+			codes += kSGRFlags[i]._code;
+		}
+	}
+
+	if ((attribs & kCharDataColor) != (old & kCharDataColor)) {
+		const unsigned int pair = (attribs & kCharDataColor) >> kCharDataColorShift;
+		if (!codes.empty())
+			codes += ';';
+		if (pair == 0 || pair >= sizeof(kForegroundCodes) / sizeof(kForegroundCodes[0])) {
+			codes += "39;49";
+		} else {
+			codes += kForegroundCodes[pair];
+			codes += ";40";
+		}
+	}
+
+	_output += "\033[" + codes + 'm';
+	_termAttribs = attribs;
+	_termAttribsKnown = true;
+}
+
+void AnsiBackend::putCell(unsigned int x, unsigned int y) {
+	const unsigned int offset = y * _width + x;
+	const CharData ch = _back[offset];
+
+	moveTo(x, y);
+	setAttribs(ch);
+
+	const bool altCharset = (ch & kAttribAltCharset) != 0;
+	if (altCharset != _termAltCharset) {
+		_output += altCharset ? '\016' : '\017';
+		_termAltCharset = altCharset;
+	}
+
+	_output += static_cast<char>(ch & kCharDataChar);
+	_front[offset] = ch;
+
+	// After writing to the last column the terminal waits
+	// with wrapping the cursor until the next character is
+	// written, thus its position is not clear.
+	if (++_termX >= static_cast<int>(_width))
+		_termX = -1;
+}
+
+} // end of namespace Intern
+} // end of namespace GUI
+
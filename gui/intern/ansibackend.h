@@ -0,0 +1,182 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GUI_INTERN_ANSIBACKEND_H
+#define GUI_INTERN_ANSIBACKEND_H
+
+#include "backend.h"
+
+#include <vector>
+#include <string>
+
+#include <stdint.h>
+#include <signal.h>
+#include <termios.h>
+
+namespace GUI {
+namespace Intern {
+
+/**
+ * A backend, which drives the terminal directly with ANSI
+ * escape sequences.
+ *
+ * It tries to write as few bytes as possible to the terminal.
+ * For that it keeps a copy of what the terminal currently shows
+ * and only outputs changed cells. Cursor movements and attribute
+ * changes are chosen by their length and when the output is
+ * shifted by a line or a column, the terminal is told to scroll
+ * instead of drawing it again.
+ */
+class AnsiBackend : public Backend {
+public:
+	/**
+	 * Creates a backend for the terminal of the standard input
+	 * and output.
+	 */
+	AnsiBackend();
+
+	/**
+	 * Creates a backend, which appends its output to the given
+	 * string instead of writing it to a terminal. The owner of
+	 * the string passes it on, for example to a network connection.
+	 *
+	 * Such a backend has a fixed size and reads no input on its
+	 * own, poll and pollPending need to be overridden for that.
+	 *
+	 * @param output String to append the output to.
+	 * @param w Width of the remote terminal.
+	 * @param h Height of the remote terminal.
+	 */
+	AnsiBackend(std::string &output, unsigned int w, unsigned int h);
+	~AnsiBackend();
+
+	unsigned int width() const { return _width; }
+	unsigned int height() const { return _height; }
+
+	void clear();
+	void putRun(unsigned int x, unsigned int y, const CharData *data, unsigned int length);
+	void setCursor(unsigned int x, unsigned int y);
+	void flush();
+
+	int poll();
+	int pollPending();
+	void updateSize();
+	void interruptPoll() { wakeUp(); }
+
+	/**
+	 * Returns the number of frames output so far.
+	 *
+	 * @return frame count.
+	 */
+	uint64_t getFrameCount() const { return _frames; }
+
+	/**
+	 * Returns the number of bytes written to the terminal so far.
+	 *
+	 * @return byte count.
+	 */
+	uint64_t getTotalBytes() const { return _totalBytes; }
+
+	/**
+	 * Returns the number of bytes written for the last frame.
+	 *
+	 * @return byte count.
+	 */
+	unsigned int getFrameBytes() const { return _frameBytes; }
+private:
+	int _in, _out;
+	termios _oldTermios;
+
+	/**
+	 * Where the output is appended to, 0 when the backend
+	 * drives the terminal of the process.
+	 */
+	std::string *const _sink;
+
+	unsigned int _width, _height;
+
+	/**
+	 * What the terminal currently shows and what it should show
+	 * after the next flush. Cells, which content is not known,
+	 * are set to kUnknownCell.
+	 */
+	typedef std::vector<CharData> CellBuffer;
+	CellBuffer _front, _back;
+	static const CharData kUnknownCell = ~static_cast<CharData>(0);
+
+	/**
+	 * Mask for all attributes, which are set via SGR.
+	 */
+	static const CharData kSGRMask = (kCharDataColor | kCharDataAttribs) & ~kAttribAltCharset;
+
+	/**
+	 * Up to how many unchanged cells are written again, instead
+	 * of moving the cursor over them.
+	 */
+	static const unsigned int kMaxRewrite = 4;
+
+	unsigned int _curX, _curY;
+
+	/**
+	 * The state of the terminal. A negative cursor position
+	 * means the position is not known.
+	 */
+	int _termX, _termY;
+	CharData _termAttribs;
+	bool _termAttribsKnown;
+	bool _termAltCharset;
+
+	std::string _output;
+
+	uint64_t _frames, _totalBytes;
+	unsigned int _frameBytes;
+
+	static volatile sig_atomic_t _resized;
+	static int _wakeupPipe[2];
+	static void handleResize(int);
+	static void wakeUp();
+	void queryTerminalSize();
+	void setSize(unsigned int w, unsigned int h);
+
+	/**
+	 * Reads a key from the terminal.
+	 *
+	 * @param timeout How long to wait for a key in ms (-1 to wait forever).
+	 * @return key, kNotifyNoInput when the timeout passed.
+	 */
+	int readKey(int timeout);
+
+	void write(const std::string &data);
+
+	void scrollLines();
+	void scrollColumns(unsigned int y);
+
+	void moveTo(unsigned int x, unsigned int y);
+	void setAttribs(CharData attribs);
+	void putCell(unsigned int x, unsigned int y);
+
+	bool isLineEqual(unsigned int a, unsigned int b) const;
+};
+
+} // end of namespace Intern
+} // end of namespace GUI
+
+#endif
+
@@ -0,0 +1,122 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GUI_INTERN_BACKEND_H
+#define GUI_INTERN_BACKEND_H
+
+#include "gui/defs.h"
+
+namespace GUI {
+namespace Intern {
+
+/**
+ * An output backend of the screen.
+ *
+ * The backend is responsible for putting the character data
+ * of the windows onto the user's display and for reading
+ * the user's input.
+ */
+class Backend {
+public:
+	virtual ~Backend() {}
+
+	/**
+	 * Queries the width of the output.
+	 *
+	 * @return width.
+	 */
+	virtual unsigned int width() const = 0;
+
+	/**
+	 * Queries the height of the output.
+	 *
+	 * @return height.
+	 */
+	virtual unsigned int height() const = 0;
+
+	/**
+	 * Clears the whole output.
+	 */
+	virtual void clear() = 0;
+
+	/**
+	 * Puts a run of characters into the given line.
+	 *
+	 * The run must not go beyond the end of the line. The
+	 * changes only need to be visible after the next flush.
+	 *
+	 * @param x x coordinate of the first character.
+	 * @param y y coordinate of the line.
+	 * @param data Character data.
+	 * @param length Number of characters.
+	 */
+	virtual void putRun(unsigned int x, unsigned int y, const CharData *data, unsigned int length) = 0;
+
+	/**
+	 * Sets the position of the cursor.
+	 *
+	 * @param x x coordinate.
+	 * @param y y coordinate.
+	 */
+	virtual void setCursor(unsigned int x, unsigned int y) = 0;
+
+	/**
+	 * Makes all changes since the last flush visible.
+	 */
+	virtual void flush() = 0;
+
+	/**
+	 * Waits for the user to enter any key.
+	 *
+	 * When the output size changed, kNotifyResize is returned.
+	 * The new size is only used after updateSize was called.
+	 *
+	 * @see Input::poll
+	 * @return User's input
+	 */
+	virtual int poll() = 0;
+
+	/**
+	 * Returns a key the user entered already, without waiting.
+	 *
+	 * @see poll
+	 * @return User's input, kNotifyNoInput when there is none.
+	 */
+	virtual int pollPending() = 0;
+
+	/**
+	 * Applies a changed output size.
+	 *
+	 * @see poll
+	 */
+	virtual void updateSize() {}
+
+	/**
+	 * Makes a poll, which is blocking in another thread, return
+	 * kNotifyError.
+	 */
+	virtual void interruptPoll() {}
+};
+
+} // end of namespace Intern
+} // end of namespace GUI
+
+#endif
+
@@ -0,0 +1,174 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "cursesbackend.h"
+#include "input.h"
+
+#include <string>
+#include <stdlib.h>
+
+namespace GUI {
+namespace Intern {
+
+namespace {
+
+/**
+ * Converts a key returned by wgetch to our own key code.
+ */
+int convertKey(int input) {
+	switch (input) {
+	case KEY_RESIZE:
+		return kNotifyResize;
+
+	case ERR:
+		return kNotifyError;
+
+	case KEY_BACKSPACE:
+		return kKeyBackspace;
+
+	default:
+		return input;
+	}
+}
+
+} // end of anonymous namespace
+
+CursesBackend::CursesBackend() : _curX(0), _curY(0), _pendingWindow(0), _run(0), _runSize(0) {
+	setenv("ESCDELAY", "10", 1);
+	initscr();
+
+	// TODO
+	if (!has_colors()) {
+		endwin();
+		throw std::string("Your terminal misses color support");
+	}
+
+	start_color();
+
+	init_pair(kWhiteOnBlack, COLOR_WHITE, COLOR_BLACK);
+	init_pair(kRedOnBlack, COLOR_RED, COLOR_BLACK);
+	init_pair(kGreenOnBlack, COLOR_GREEN, COLOR_BLACK);
+	init_pair(kYellowOnBlack, COLOR_YELLOW, COLOR_BLACK);
+	init_pair(kBlueOnBlack, COLOR_BLUE, COLOR_BLACK);
+	init_pair(kMagentaOnBlack, COLOR_MAGENTA, COLOR_BLACK);
+	init_pair(kCyanOnBlack, COLOR_CYAN, COLOR_BLACK);
+
+	attron(COLOR_PAIR(kWhiteOnBlack));
+
+	cbreak();
+	noecho();
+	keypad(stdscr, TRUE);
+	notimeout(stdscr, TRUE);
+
+	_pendingWindow = newwin(1, 1, 0, 0);
+	keypad(_pendingWindow, TRUE);
+	nodelay(_pendingWindow, TRUE);
+	// An untouched window is not refreshed by wgetch.
+	untouchwin(_pendingWindow);
+}
+
+CursesBackend::~CursesBackend() {
+	delete[] _run;
+	delwin(_pendingWindow);
+	endwin();
+}
+
+unsigned int CursesBackend::width() const {
+	return COLS;
+}
+
+unsigned int CursesBackend::height() const {
+	return LINES;
+}
+
+void CursesBackend::clear() {
+	::erase();
+	refresh();
+}
+
+void CursesBackend::putRun(unsigned int x, unsigned int y, const CharData *data, unsigned int length) {
+	if (length > _runSize) {
+		delete[] _run;
+		_run = new chtype[length];
+		_runSize = length;
+	}
+
+	// mvaddchnstr does not apply the current attributes like
+	// addch does, thus we need to merge them in here. Also the
+	// line drawing glyphs need to be looked up in the terminal's
+	// character set.
+	const chtype attribs = static_cast<chtype>(getattrs(stdscr));
+	for (unsigned int i = 0; i < length; ++i) {
+		const CharData src = data[i];
+		chtype ch = src & kCharDataChar;
+
+		if (src & kAttribAltCharset)
+			ch = NCURSES_ACS(ch);
+
+		if (src & kCharDataColor)
+			ch |= COLOR_PAIR((src & kCharDataColor) >> kCharDataColorShift);
+		else
+			ch |= attribs & A_COLOR;
+
+		if (src & kAttribUnderline)
+			ch |= A_UNDERLINE;
+		if (src & kAttribReverse)
+			ch |= A_REVERSE;
+		if (src & kAttribDim)
+			ch |= A_DIM;
+		if (src & kAttribBold)
+			ch |= A_BOLD;
+
+		_run[i] = ch | (attribs & ~A_COLOR);
+	}
+
+	mvaddchnstr(y, x, _run, length);
+}
+
+void CursesBackend::setCursor(unsigned int x, unsigned int y) {
+	_curX = x;
+	_curY = y;
+}
+
+void CursesBackend::flush() {
+	move(_curY, _curX);
+
+	// Reading a key refreshes the screen too, but frames drawn
+	// without waiting for a key (like when watching or in real
+	// time mode) need to be output right away.
+	refresh();
+}
+
+int CursesBackend::poll() {
+	refresh();
+
+	return convertKey(wgetch(stdscr));
+}
+
+int CursesBackend::pollPending() {
+	const int input = wgetch(_pendingWindow);
+	if (input == ERR)
+		return kNotifyNoInput;
+	return convertKey(input);
+}
+
+} // end of namespace Intern
+} // end of namespace GUI
+
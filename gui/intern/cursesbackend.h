@@ -0,0 +1,69 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GUI_INTERN_CURSESBACKEND_H
+#define GUI_INTERN_CURSESBACKEND_H
+
+#include "backend.h"
+
+#include <ncurses.h>
+
+namespace GUI {
+namespace Intern {
+
+/**
+ * A backend, which uses ncurses for output and input.
+ */
+class CursesBackend : public Backend {
+public:
+	CursesBackend();
+	~CursesBackend();
+
+	unsigned int width() const;
+	unsigned int height() const;
+
+	void clear();
+	void putRun(unsigned int x, unsigned int y, const CharData *data, unsigned int length);
+	void setCursor(unsigned int x, unsigned int y);
+	void flush();
+
+	int poll();
+	int pollPending();
+private:
+	unsigned int _curX, _curY;
+
+	/**
+	 * A window, which is never drawn to. It is used to check for
+	 * pending keys, since reading from stdscr refreshes it.
+	 */
+	WINDOW *_pendingWindow;
+
+	/**
+	 * Buffer for the converted run data.
+	 */
+	chtype *_run;
+	unsigned int _runSize;
+};
+
+} // end of namespace Intern
+} // end of namespace GUI
+
+#endif
+
@@ -20,9 +20,6 @@
 
 #include "drawdesc.h"
 
-#include "game/tiledatabase.h"
-#include "game/monsterdatabase.h"
-
 #include <cassert>
 
 #include <boost/foreach.hpp>
@@ -43,7 +40,7 @@ DrawDescParser::DefinitionLoader::Definition DrawDescParser::definitionRule(cons
 	return DrawDescParser::DefinitionLoader::Definition(n->second, DrawDesc(parseSymbol(g->second), parseColor(c->second), parseAttribs(a->second)));
 }
 
-chtype DrawDescParser::parseSymbol(const std::string &value) throw (Base::ParserListener::Exception) {
+CharData DrawDescParser::parseSymbol(const std::string &value) throw (Base::ParserListener::Exception) {
 	if (value.size() == 1) {
 		return value[0];
 	} else {
@@ -122,12 +119,11 @@ int DrawDescParser::parseAttribs(const std::string &value) throw (Base::ParserLi
 		throw Base::ParserListener::Exception("Unknown attribs value \"" + value + '"');
 }
 
-TileDDMap *parseTileDefinitons(const std::string &filename) throw (Base::NonRecoverableException) {
+TileDDMap *parseTileDefinitons(const std::string &filename, const Game::TileDatabase &tdb) throw (Base::NonRecoverableException) {
 	DrawDescParser parser("-tile");
 	DrawDescParser::DefinitionList dds = parser.load(filename);
 	TileDDMap::DrawDescMap drawDescs;
 
-	Game::TileDatabase &tdb = Game::TileDatabase::instance();
 	const Game::Tile lastTileType = tdb.getTileCount();
 
 	BOOST_FOREACH(const DrawDescParser::DefinitionList::value_type &i, dds) {
@@ -149,12 +145,11 @@ TileDDMap *parseTileDefinitons(const std::string &filename) throw (Base::NonReco
 	return new TileDDMap(drawDescs);
 }
 
-MonsterDDMap *parseMonsterDefinitions(const std::string &filename) throw (Base::NonRecoverableException) {
+MonsterDDMap *parseMonsterDefinitions(const std::string &filename, const Game::MonsterDatabase &mdb) throw (Base::NonRecoverableException) {
 	DrawDescParser parser("-monster");
 	DrawDescParser::DefinitionList dds = parser.load(filename);
 	MonsterDDMap::DrawDescMap drawDescs;
 
-	Game::MonsterDatabase &mdb = g_monsterDatabase;
 	const Game::MonsterType lastMonsterType = mdb.getMonsterTypeCount();
 
 	BOOST_FOREACH(const DrawDescParser::DefinitionList::value_type &i, dds) {
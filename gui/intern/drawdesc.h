@@ -27,6 +27,8 @@
 
 #include "game/map.h"
 #include "game/monsterdefinition.h"
+#include "game/tiledatabase.h"
+#include "game/monsterdatabase.h"
 
 #include <map>
 #include <string>
@@ -36,9 +38,9 @@ namespace Intern {
 
 struct DrawDesc {
 	DrawDesc() : _symbol(0), _color(kWhiteOnBlack), _attribs(0) {}
-	DrawDesc(chtype symbol, ColorPair color, int attribs) : _symbol(symbol), _color(color), _attribs(attribs) {}
+	DrawDesc(CharData symbol, ColorPair color, int attribs) : _symbol(symbol), _color(color), _attribs(attribs) {}
 
-	chtype _symbol;
+	CharData _symbol;
 	ColorPair _color;
 	int _attribs;
 };
@@ -48,21 +50,22 @@ class ASCIIRepresentation {
 public:
 	typedef std::map<Key, DrawDesc> DrawDescMap;
 
-	ASCIIRepresentation(const DrawDescMap &descs) : _descs(descs) {}
+	ASCIIRepresentation(const DrawDescMap &descs) : _descs(descs), _default() {}
 
 	bool hasEntry(const Key &key) const {
 		return (_descs.find(key) != _descs.end());
 	}
 
-	DrawDesc lookUp(const Key &key) const {
+	const DrawDesc &lookUp(const Key &key) const {
 		typename DrawDescMap::const_iterator i = _descs.find(key);
 		if (i != _descs.end())
 			return i->second;
 		else
-			return DrawDesc();
+			return _default;
 	}
 private:
 	DrawDescMap _descs;
+	const DrawDesc _default;
 };
 
 class DrawDescParser : public Base::DefinitionLoader<std::pair<std::string, DrawDesc> > {
@@ -73,16 +76,16 @@ public:
 private:
 	DefinitionLoader::Definition definitionRule(const Base::Matcher::ValueMap &values) throw (Base::ParserListener::Exception);
 
-	chtype parseSymbol(const std::string &value) throw (Base::ParserListener::Exception);
+	CharData parseSymbol(const std::string &value) throw (Base::ParserListener::Exception);
 	ColorPair parseColor(const std::string &value) throw (Base::ParserListener::Exception);
 	int parseAttribs(const std::string &value) throw (Base::ParserListener::Exception);
 };
 
 typedef ASCIIRepresentation<Game::Tile> TileDDMap;
-TileDDMap *parseTileDefinitons(const std::string &filename) throw (Base::NonRecoverableException);
+TileDDMap *parseTileDefinitons(const std::string &filename, const Game::TileDatabase &tdb) throw (Base::NonRecoverableException);
 
 typedef ASCIIRepresentation<Game::MonsterType> MonsterDDMap;
-MonsterDDMap *parseMonsterDefinitions(const std::string &filename) throw (Base::NonRecoverableException);
+MonsterDDMap *parseMonsterDefinitions(const std::string &filename, const Game::MonsterDatabase &mdb) throw (Base::NonRecoverableException);
 
 } // end of namespace Intern
 } // end of namespace GUI
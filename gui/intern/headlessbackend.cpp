@@ -0,0 +1,85 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "headlessbackend.h"
+#include "input.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace GUI {
+namespace Intern {
+
+NullBackend::NullBackend(unsigned int w, unsigned int h) : _width(w), _height(h), _keys(), _frames(0) {
+}
+
+int NullBackend::poll() {
+	if (_keys.empty())
+		return kKeyEscape;
+
+	const int key = _keys.front();
+	_keys.pop_front();
+	return key;
+}
+
+int NullBackend::pollPending() {
+	// The script is never waited for, thus every key left is
+	// pending. The escape key is only for waiting on the end of
+	// the script, it would fill all of the input queue otherwise.
+	if (_keys.empty())
+		return kNotifyNoInput;
+	return poll();
+}
+
+void NullBackend::addKeys(const std::string &keys) {
+	for (std::string::const_iterator i = keys.begin(); i != keys.end(); ++i)
+		_keys.push_back(static_cast<unsigned char>(*i));
+}
+
+MemoryBackend::MemoryBackend(unsigned int w, unsigned int h)
+    : NullBackend(w, h), _framebuffer(w * h, ' '), _curX(0), _curY(0) {
+}
+
+void MemoryBackend::clear() {
+	std::fill(_framebuffer.begin(), _framebuffer.end(), ' ');
+}
+
+void MemoryBackend::putRun(unsigned int x, unsigned int y, const CharData *data, unsigned int length) {
+	assert(y < _height);
+	assert(x + length <= _width);
+
+	std::copy(data, data + length, _framebuffer.begin() + y * _width + x);
+}
+
+void MemoryBackend::setCursor(unsigned int x, unsigned int y) {
+	_curX = x;
+	_curY = y;
+}
+
+std::string MemoryBackend::getLine(unsigned int y) const {
+	std::string line;
+	for (unsigned int x = 0; x < _width; ++x)
+		line += static_cast<char>(_framebuffer[y * _width + x] & kCharDataChar);
+	return line;
+}
+
+} // end of namespace Intern
+} // end of namespace GUI
+
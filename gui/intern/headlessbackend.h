@@ -0,0 +1,144 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GUI_INTERN_HEADLESSBACKEND_H
+#define GUI_INTERN_HEADLESSBACKEND_H
+
+#include "backend.h"
+
+#include <deque>
+#include <vector>
+#include <string>
+
+#include <stdint.h>
+
+namespace GUI {
+namespace Intern {
+
+/**
+ * A backend, which discards all output.
+ *
+ * The input is taken from a script of keys. When the script
+ * is exhausted, waiting for a key returns the escape key, so
+ * a game run with this backend always ends.
+ *
+ * This is useful for processes, which only simulate games,
+ * and as base for other backends, which do not need a
+ * terminal.
+ */
+class NullBackend : public Backend {
+public:
+	/**
+	 * Creates a backend with the given output size.
+	 *
+	 * @param w Width of the output.
+	 * @param h Height of the output.
+	 */
+	NullBackend(unsigned int w = 80, unsigned int h = 24);
+
+	unsigned int width() const { return _width; }
+	unsigned int height() const { return _height; }
+
+	void clear() {}
+	void putRun(unsigned int, unsigned int, const CharData *, unsigned int) {}
+	void setCursor(unsigned int, unsigned int) {}
+	void flush() { ++_frames; }
+
+	int poll();
+	int pollPending();
+
+	/**
+	 * Adds a key to the input script.
+	 *
+	 * @param key Key to add.
+	 */
+	void addKey(int key) { _keys.push_back(key); }
+
+	/**
+	 * Adds all characters of the string to the input script.
+	 *
+	 * @param keys Keys to add.
+	 */
+	void addKeys(const std::string &keys);
+
+	/**
+	 * Returns the number of frames output so far.
+	 *
+	 * @return frame count.
+	 */
+	uint64_t getFrameCount() const { return _frames; }
+protected:
+	const unsigned int _width, _height;
+private:
+	std::deque<int> _keys;
+	uint64_t _frames;
+};
+
+/**
+ * A backend, which renders into a framebuffer in memory.
+ *
+ * The input is handled like with the NullBackend.
+ */
+class MemoryBackend : public NullBackend {
+public:
+	/**
+	 * Creates a backend with the given framebuffer size.
+	 *
+	 * @param w Width of the framebuffer.
+	 * @param h Height of the framebuffer.
+	 */
+	MemoryBackend(unsigned int w = 80, unsigned int h = 24);
+
+	void clear();
+	void putRun(unsigned int x, unsigned int y, const CharData *data, unsigned int length);
+	void setCursor(unsigned int x, unsigned int y);
+
+	/**
+	 * Returns the character data at the given position.
+	 *
+	 * @param x x coordinate.
+	 * @param y y coordinate.
+	 * @return character data.
+	 */
+	CharData getCell(unsigned int x, unsigned int y) const { return _framebuffer[y * _width + x]; }
+
+	/**
+	 * Returns the characters of the given line, without any
+	 * attributes.
+	 *
+	 * @param y y coordinate of the line.
+	 * @return line.
+	 */
+	std::string getLine(unsigned int y) const;
+
+	/**
+	 * Queries the cursor coordinates.
+	 */
+	void getCursor(unsigned int &x, unsigned int &y) const { x = _curX; y = _curY; }
+private:
+	std::vector<CharData> _framebuffer;
+	unsigned int _curX, _curY;
+};
+
+} // end of namespace Intern
+} // end of namespace GUI
+
+#endif
+
@@ -28,20 +28,47 @@
 namespace GUI {
 namespace Intern {
 
-Input *Input::_instance = 0;
-
 int Input::poll() {
-	refresh();
-	return wgetch(stdscr);
+	Backend &backend = _screen.getBackend();
+
+	int input;
+	if (_pending.isEmpty()) {
+		input = backend.poll();
+	} else {
+		input = _pending.front();
+		_pending.popFront();
+	}
+
+	if (input == kNotifyResize)
+		backend.updateSize();
+	return input;
+}
+
+bool Input::hasPendingInput() {
+	Backend &backend = _screen.getBackend();
+
+	while (!_pending.isFull()) {
+		const int input = backend.pollPending();
+		if (input == kNotifyNoInput || input == kNotifyError)
+			break;
+		_pending.pushBack(input);
+	}
+
+	return !_pending.isEmpty();
+}
+
+void Input::waitForInput() {
+	if (_pending.isEmpty())
+		_pending.pushBack(_screen.getBackend().poll());
 }
 
 const std::string Input::getLine(Window &win, unsigned int x, unsigned int y) {
 	if (x >= win.getWidth() || y >= win.getHeight())
 		return std::string();
 
-	int oX, oY;
-	getyx(stdscr, oY, oX);
-	Screen &scr = Screen::instance();
+	Screen &scr = _screen;
+	unsigned int oX, oY;
+	scr.getCursor(oX, oY);
 
 	std::string line;
 
@@ -72,17 +99,6 @@ const std::string Input::getLine(Window &win, unsigned int x, unsigned int y) {
 	return line;
 }
 
-Input &Input::instance() {
-	if (!_instance)
-		_instance = new Input();
-	return *_instance;
-}
-
-void Input::destroy() {
-	delete _instance;
-	_instance = 0;
-}
-
 } // end of namespace Intern
 } // end of namespace GUI
 
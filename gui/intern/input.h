@@ -22,22 +22,32 @@
 #define GUI_INTERN_INPUT_H
 
 #include "window.h"
+#include "screen.h"
 
 #include "gui/defs.h"
 
-#include <ncurses.h>
+#include "base/ringbuffer.h"
+
 #include <string>
 
 namespace GUI {
 namespace Intern {
 
 enum Notifications {
-	kNotifyResize = KEY_RESIZE,
-	kNotifyError = ERR
+	kNotifyResize = 0x200,
+	kNotifyNoInput = 0x201,
+	kNotifyError = -1
 };
 
 class Input {
 public:
+	/**
+	 * Creates the input handling of the given screen.
+	 *
+	 * @param screen Screen, whose backend is used for input.
+	 */
+	explicit Input(Screen &screen) : _screen(screen), _pending() {}
+
 	/**
 	 * Waits for the user to enter any key.
 	 *
@@ -45,11 +55,30 @@ public:
 	 * values defined via Keys or an unknown value in case the key
 	 * pressed is not known.
 	 *
+	 * Keys, which were typed ahead, are returned first.
+	 *
 	 * @see Keys
 	 * @return User's input
 	 */
 	int poll();
 
+	/**
+	 * Checks whether the user typed any keys, which were not
+	 * returned by poll yet.
+	 *
+	 * This does not wait for the user. All keys the backend has
+	 * pending are moved into the type ahead queue.
+	 *
+	 * @return true when keys are pending, false otherwise.
+	 */
+	bool hasPendingInput();
+
+	/**
+	 * Waits until the user typed any key, which was not returned
+	 * by poll yet. The key is kept for the next poll.
+	 */
+	void waitForInput();
+
 	/**
 	 * Reads a line from the user. This will allow for a terminal a-like
 	 * input for the user. The users string will be started at (x, y)
@@ -64,18 +93,14 @@ public:
 	 * @return the string the user entered
 	 */
 	const std::string getLine(Window &win, unsigned int x, unsigned int y);
+private:
+	Screen &_screen;
 
 	/**
-	 * Returns the global input instance.
-	 */
-	static Input &instance();
-
-	/**
-	 * Destroies the global input instance.
+	 * The keys typed ahead.
 	 */
-	static void destroy();
-private:
-	static Input *_instance;
+	typedef Base::RingBuffer<int, 256> KeyQueue;
+	KeyQueue _pending;
 };
 
 } // end of namespace Intern
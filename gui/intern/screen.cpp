@@ -21,67 +21,27 @@
 #include "screen.h"
 #include "window.h"
 
-#include <ncurses.h>
-
-#include <algorithm>
-#include <functional>
-#include <string>
 #include <cassert>
-#include <stdlib.h>
 
 namespace GUI {
 namespace Intern {
 
-Screen *Screen::_instance = 0;
-
-Screen::Screen() : _needRedraw(false), _curX(0), _curY(0), _windows() {
-	setenv("ESCDELAY", "10", 1);
-	initscr();
-
-	// TODO
-	if (!has_colors())
-		throw std::string("Your terminal misses color support");
-
-	start_color();
-
-	init_pair(kWhiteOnBlack, COLOR_WHITE, COLOR_BLACK);
-	init_pair(kRedOnBlack, COLOR_RED, COLOR_BLACK);
-	init_pair(kGreenOnBlack, COLOR_GREEN, COLOR_BLACK);
-	init_pair(kYellowOnBlack, COLOR_YELLOW, COLOR_BLACK);
-	init_pair(kBlueOnBlack, COLOR_BLUE, COLOR_BLACK);
-	init_pair(kMagentaOnBlack, COLOR_MAGENTA, COLOR_BLACK);
-	init_pair(kCyanOnBlack, COLOR_CYAN, COLOR_BLACK);
-
-	attron(COLOR_PAIR(kWhiteOnBlack));
-
-	cbreak();
-	noecho();
-	keypad(stdscr, TRUE);
-	notimeout(stdscr, TRUE);
+Screen::Screen(Backend *backend) : _backend(backend), _needRedraw(false), _curX(0), _curY(0), _windows() {
 }
 
 Screen::~Screen() {
-	endwin();
-}
-
-Screen &Screen::instance() {
-	if (!_instance)
-		_instance = new Screen;
-	return *_instance;
-}
-
-void Screen::destroy() {
-	delete _instance;
-	_instance = 0;
+	delete _backend;
 }
 
 void Screen::clear() {
-	::erase();
-	refresh();
+	_backend->clear();
 	_needRedraw = true;
 }
 
 void Screen::add(Window *window) {
+	assert(window->_rX + window->_rW <= width());
+	assert(window->_rY + window->_rH <= height());
+
 	remove(window);
 	_windows.push_back(window);
 	_needRedraw = true;
@@ -111,15 +71,12 @@ void Screen::getCursor(unsigned int &x, unsigned int &y) {
 }
 
 void Screen::update() {
-	std::for_each(_windows.begin(), _windows.end(), std::bind2nd(std::mem_fun(&Window::redraw), _needRedraw));
+	for (WindowList::iterator i = _windows.begin(); i != _windows.end(); ++i)
+		(*i)->redraw(*_backend, _needRedraw);
 	_needRedraw = false;
-	move(_curY, _curX);
 
-	// According to the ncurses manpage we should need to call refresh
-	// here to update the screen. Somehow that is not needed though,
-	// if any curses implementation requires that, just uncomment this
-	// line.
-	//refresh();
+	_backend->setCursor(_curX, _curY);
+	_backend->flush();
 }
 
 } // end of namespace Intern
@@ -22,6 +22,7 @@
 #define GUI_INTERN_SCREEN_H
 
 #include "window.h"
+#include "backend.h"
 
 #include "gui/defs.h"
 
@@ -34,17 +35,15 @@ class Window;
 
 class Screen {
 public:
-	~Screen();
-
 	/**
-	 * Returns the global screen instance.
-	 */
-	static Screen &instance();
-
-	/**
-	 * Destroies the global screen instance.
+	 * Creates a screen with the given backend.
+	 *
+	 * The screen takes over the ownership of the backend.
+	 *
+	 * @param backend Backend to use for output and input.
 	 */
-	static void destroy();
+	explicit Screen(Backend *backend);
+	~Screen();
 
 	/**
 	 * Clears all of the screen. This will not erase
@@ -110,17 +109,26 @@ public:
 	 *
 	 * @return width.
 	 */
-	unsigned int width() const { return COLS; }
+	unsigned int width() const { return _backend->width(); }
 
 	/**
 	 * Queries the height of the screen.
 	 *
 	 * @return height.
 	 */
-	unsigned int height() const { return LINES; }
+	unsigned int height() const { return _backend->height(); }
+
+	/**
+	 * Returns the backend of the screen.
+	 *
+	 * @return backend.
+	 */
+	Backend &getBackend() { return *_backend; }
 private:
-	Screen();
-	static Screen *_instance;
+	Screen(const Screen &);
+	Screen &operator=(const Screen &);
+
+	Backend *_backend;
 
 	bool _needRedraw;
 	unsigned int _curX, _curY;
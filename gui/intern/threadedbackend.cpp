@@ -0,0 +1,224 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "threadedbackend.h"
+#include "input.h"
+
+#include <algorithm>
+
+namespace GUI {
+namespace Intern {
+
+namespace {
+
+/**
+ * The number of keys, which can be typed ahead.
+ */
+const size_t kKeyQueueSize = 256;
+
+} // end of anonymous namespace
+
+void ThreadedBackend::Frame::resize(unsigned int w, unsigned int h) {
+	_width = w;
+	_height = h;
+	_cells.assign(w * h, ' ');
+	// Keep the cursor inside the frame, an empty frame only has
+	// room for it at the origin.
+	_curX = w ? std::min(_curX, w - 1) : 0;
+	_curY = h ? std::min(_curY, h - 1) : 0;
+}
+
+ThreadedBackend::ThreadedBackend(Backend *backend)
+    : _backend(backend), _shadow(), _frames(), _rendered(), _keys(kKeyQueueSize), _quit(false),
+      _backendMutex(), _frameMutex(), _frameAvailable(), _keyMutex(), _keyAvailable(),
+      _renderThread(), _inputThread() {
+	_shadow.resize(_backend->width(), _backend->height());
+
+	_renderThread = boost::thread(&ThreadedBackend::renderLoop, this);
+	_inputThread = boost::thread(&ThreadedBackend::inputLoop, this);
+}
+
+ThreadedBackend::~ThreadedBackend() {
+	finish();
+	delete _backend;
+}
+
+void ThreadedBackend::finish() {
+	if (_quit)
+		return;
+
+	{
+		boost::lock_guard<boost::mutex> lock(_frameMutex);
+		_quit = true;
+	}
+	_frameAvailable.notify_one();
+	_renderThread.join();
+
+	_backend->interruptPoll();
+	_inputThread.join();
+}
+
+void ThreadedBackend::clear() {
+	std::fill(_shadow._cells.begin(), _shadow._cells.end(), ' ');
+	++_shadow._clears;
+}
+
+void ThreadedBackend::putRun(unsigned int x, unsigned int y, const CharData *data, unsigned int length) {
+	if (y >= _shadow._height || x >= _shadow._width)
+		return;
+	length = std::min(length, _shadow._width - x);
+
+	std::copy(data, data + length, _shadow._cells.begin() + y * _shadow._width + x);
+}
+
+void ThreadedBackend::setCursor(unsigned int x, unsigned int y) {
+	_shadow._curX = x;
+	_shadow._curY = y;
+}
+
+void ThreadedBackend::flush() {
+	// The back buffer is reused, thus this normally does not
+	// need to allocate any memory.
+	_frames.getBack() = _shadow;
+	_frames.publish();
+
+	// The lock is only needed, so the render thread can not miss
+	// the notification between checking for a frame and waiting.
+	{
+		boost::lock_guard<boost::mutex> lock(_frameMutex);
+	}
+	_frameAvailable.notify_one();
+}
+
+int ThreadedBackend::poll() {
+	int key = 0;
+
+	boost::unique_lock<boost::mutex> lock(_keyMutex);
+	while (!_keys.pop(key))
+		_keyAvailable.wait(lock);
+
+	return key;
+}
+
+int ThreadedBackend::pollPending() {
+	int key = 0;
+	if (!_keys.pop(key))
+		return kNotifyNoInput;
+	return key;
+}
+
+void ThreadedBackend::updateSize() {
+	unsigned int w, h;
+
+	{
+		boost::lock_guard<boost::mutex> lock(_backendMutex);
+		_backend->updateSize();
+		w = _backend->width();
+		h = _backend->height();
+	}
+
+	_shadow.resize(w, h);
+	++_shadow._clears;
+}
+
+void ThreadedBackend::renderLoop() {
+	while (true) {
+		{
+			boost::unique_lock<boost::mutex> lock(_frameMutex);
+			while (!_frames.hasFresh() && !_quit)
+				_frameAvailable.wait(lock);
+		}
+
+		// Frames, which were published in the meantime, are
+		// skipped, only the most recent one is of interest.
+		if (!_frames.consume())
+			break;
+
+		render(_frames.getFront());
+	}
+}
+
+void ThreadedBackend::render(const Frame &frame) {
+	boost::lock_guard<boost::mutex> lock(_backendMutex);
+
+	// The frame might be from before the output size changed.
+	if (frame._width != _backend->width() || frame._height != _backend->height())
+		return;
+
+	const bool full = (frame._clears != _rendered._clears || frame._width != _rendered._width || frame._height != _rendered._height);
+	if (frame._clears != _rendered._clears)
+		_backend->clear();
+
+	for (unsigned int y = 0; y < frame._height; ++y) {
+		const CharData *src = &frame._cells[y * frame._width];
+
+		if (full) {
+			_backend->putRun(0, y, src, frame._width);
+			continue;
+		}
+
+		// Only put the part of the line, which changed, onto
+		// the backend.
+		const CharData *old = &_rendered._cells[y * frame._width];
+		unsigned int first = 0, last = frame._width;
+		while (first < last && src[first] == old[first])
+			++first;
+		while (last > first && src[last - 1] == old[last - 1])
+			--last;
+
+		if (first < last)
+			_backend->putRun(first, y, src + first, last - first);
+	}
+
+	_backend->setCursor(frame._curX, frame._curY);
+	_backend->flush();
+
+	_rendered = frame;
+}
+
+void ThreadedBackend::inputLoop() {
+	while (!_quit) {
+		const int key = _backend->poll();
+		if (_quit)
+			break;
+
+		if (key == kNotifyError) {
+			// Do not spin in case the input is broken.
+			boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+			continue;
+		}
+
+		while (!_keys.push(key)) {
+			if (_quit)
+				return;
+			boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+		}
+
+		// See flush for why the lock is needed.
+		{
+			boost::lock_guard<boost::mutex> lock(_keyMutex);
+		}
+		_keyAvailable.notify_one();
+	}
+}
+
+} // end of namespace Intern
+} // end of namespace GUI
+
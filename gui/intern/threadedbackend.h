@@ -0,0 +1,146 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GUI_INTERN_THREADEDBACKEND_H
+#define GUI_INTERN_THREADEDBACKEND_H
+
+#include "backend.h"
+
+#include "base/triplebuffer.h"
+#include "base/spscqueue.h"
+
+#include <vector>
+
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+
+namespace GUI {
+namespace Intern {
+
+/**
+ * A backend, which runs the output and the input of another
+ * backend in threads of their own.
+ *
+ * Every flush publishes a snapshot of the whole screen through a
+ * triple buffer to the render thread, which puts the most recent
+ * snapshot onto the other backend. Thus slow output never stalls
+ * the caller. The input thread polls the other backend all the
+ * time and passes the keys on through a queue, thus keys typed
+ * ahead are never lost.
+ *
+ * The other backend must allow output and input to be done from
+ * different threads.
+ */
+class ThreadedBackend : public Backend {
+public:
+	/**
+	 * Creates the backend and starts its threads.
+	 *
+	 * The backend takes over the ownership of the other backend.
+	 *
+	 * @param backend Backend to use for output and input.
+	 */
+	explicit ThreadedBackend(Backend *backend);
+	~ThreadedBackend();
+
+	/**
+	 * Waits until the last published frame is put onto the other
+	 * backend and stops both threads.
+	 *
+	 * Afterwards the backend can not be used anymore. This is
+	 * automatically done on destruction.
+	 */
+	void finish();
+
+	unsigned int width() const { return _shadow._width; }
+	unsigned int height() const { return _shadow._height; }
+
+	void clear();
+	void putRun(unsigned int x, unsigned int y, const CharData *data, unsigned int length);
+	void setCursor(unsigned int x, unsigned int y);
+	void flush();
+
+	int poll();
+	int pollPending();
+	void updateSize();
+private:
+	Backend *_backend;
+
+	/**
+	 * A snapshot of the screen.
+	 */
+	struct Frame {
+		Frame() : _width(0), _height(0), _cells(), _curX(0), _curY(0), _clears(0) {}
+
+		unsigned int _width, _height;
+		std::vector<CharData> _cells;
+		unsigned int _curX, _curY;
+
+		/**
+		 * How often the screen was cleared so far.
+		 */
+		unsigned int _clears;
+
+		void resize(unsigned int w, unsigned int h);
+	};
+
+	/**
+	 * The current screen content, it is copied into the triple
+	 * buffer on every flush.
+	 */
+	Frame _shadow;
+	Base::TripleBuffer<Frame> _frames;
+
+	/**
+	 * The screen content last put onto the other backend.
+	 */
+	Frame _rendered;
+
+	Base::SPSCQueue<int> _keys;
+
+	boost::atomic<bool> _quit;
+
+	/**
+	 * Locks the other backend. The render thread holds it, while
+	 * putting a frame onto the backend, and it is needed to
+	 * change the output size.
+	 */
+	boost::mutex _backendMutex;
+
+	boost::mutex _frameMutex;
+	boost::condition_variable _frameAvailable;
+
+	boost::mutex _keyMutex;
+	boost::condition_variable _keyAvailable;
+
+	boost::thread _renderThread;
+	boost::thread _inputThread;
+
+	void renderLoop();
+	void render(const Frame &frame);
+
+	void inputLoop();
+};
+
+} // end of namespace Intern
+} // end of namespace GUI
+
+#endif
+
@@ -19,7 +19,6 @@
  */
 
 #include "window.h"
-#include "screen.h"
 
 #include <cassert>
 #include <cstring>
@@ -30,31 +29,32 @@
 namespace GUI {
 namespace Intern {
 
+const CharData Window::kUnflushedCell;
+
 Window::Window(unsigned int x, unsigned int y, unsigned int w, unsigned int h, bool border)
     : _x(border ? x + 1 : x),
       _y(border ? y + 1 : y),
       _w(border ? w - 2 : w),
       _h(border ? h - 2 : h),
       _rX(x), _rY(y), _rW(w), _rH(h),
-      _content(0),
+      _content(0), _flushed(0),
       _hasBorder(border),
       _needsRefresh(true) {
-	Screen &screen = Screen::instance();
-
-	assert(x + w <= screen.width());
-	assert(y + h <= screen.height());
-
-	_content = new chtype[_rW * _rH];
+	_content = new CharData[_rW * _rH];
 	assert(_content);
+	_flushed = new CharData[_rW * _rH];
+	assert(_flushed);
+	std::fill(_flushed, _flushed + _rW * _rH, kUnflushedCell);
 	clear();
 }
 
 Window::~Window() {
 	delete[] _content;
+	delete[] _flushed;
 }
 
 void Window::putData(unsigned int x, unsigned int y, unsigned int width,
-                     unsigned int height, const chtype *data, unsigned int pitch) {
+                     unsigned int height, const CharData *data, unsigned int pitch) {
 	if (y >= _h || x >= _w)
 		return;
 	if (y + height > _h || x + width > _w)
@@ -65,10 +65,10 @@ void Window::putData(unsigned int x, unsigned int y, unsigned int width,
 		++x;
 	}
 
-	chtype *dst = _content + y * _rW + x;
+	CharData *dst = _content + y * _rW + x;
 
 	while (height--) {
-		std::memcpy(dst, data, width * sizeof(chtype));
+		std::memcpy(dst, data, width * sizeof(CharData));
 		dst += _rW;
 		data += pitch;
 	}
@@ -76,7 +76,7 @@ void Window::putData(unsigned int x, unsigned int y, unsigned int width,
 	_needsRefresh = true;
 }
 
-void Window::printChar(chtype ch, unsigned int x, unsigned int y, ColorPair color, int attrib) {
+void Window::printChar(CharData ch, unsigned int x, unsigned int y, ColorPair color, int attrib) {
 	if (y >= _h || x >= _w)
 		return;
 
@@ -108,29 +108,29 @@ void Window::printLine(const char *str, unsigned int x, unsigned int y, ColorPai
 }
 
 void Window::clear() {
-	chtype *dst = _content;
+	CharData *dst = _content;
 	for (unsigned int y = 0; y < _rH; ++y) {
 		for (unsigned int x = 0; x < _rW; ++x)
 			*dst++ = ' ';
 	}
 
 	if (_hasBorder) {
-		dst[      0] = ACS_ULCORNER;
-		dst[_rW - 1] = ACS_URCORNER;
-		dst[(_rH - 1) * _rW + 0] = ACS_LLCORNER;
-		dst[(_rH - 1) * _rW + _rW - 1] = ACS_LLCORNER;
+		dst[      0] = kUpperLeftEdge;
+		dst[_rW - 1] = kUpperRightEdge;
+		dst[(_rH - 1) * _rW + 0] = kLowerLeftEdge;
+		dst[(_rH - 1) * _rW + _rW - 1] = kLowerLeftEdge;
 
-		chtype *dst1 = _content + 1, *dst2 = _content + (_rH - 1) * _rW + 1;
+		CharData *dst1 = _content + 1, *dst2 = _content + (_rH - 1) * _rW + 1;
 		// Top/Bottom line
 		for (unsigned int i = 0; i < _w; ++i)
-			*dst1++ = *dst2++ = ACS_HLINE;
+			*dst1++ = *dst2++ = kHorizontalLine;
 
 		// Left/Right line
 		dst1 = _content + 1 * _rW;
 		dst2 = _content + 2 * _rW - 1; 
 
 		for (unsigned int i = 0; i < _h; ++i) {
-			*dst1 = *dst2 = ACS_VLINE;
+			*dst1 = *dst2 = kVerticalLine;
 			dst1 += _rW;
 			dst2 += _rW;
 		}
@@ -138,19 +138,45 @@ void Window::clear() {
 	_needsRefresh = true;
 }
 
-void Window::redraw(bool force) {
-	if (_needsRefresh || force) {
-		const chtype *src = _content;
-
-		move(_rY, _rX);
+void Window::redraw(Backend &backend, bool force) {
+	if (force) {
+		for (unsigned int y = 0; y < _rH; ++y)
+			flushRun(backend, 0, y, _rW);
+	} else if (_needsRefresh) {
+		// Only output the changed runs of every line. Runs, which
+		// are only separated by a few unchanged cells, are output
+		// at once, that is cheaper than moving the cursor.
 		for (unsigned int y = 0; y < _rH; ++y) {
-			if (_rY != 0 || _rX != 0 || _rW != 80)
-				move(_rY + y, _rX);
-
-			for (unsigned int x = 0; x < _rW; ++x)
-				addch(*src++);
+			const CharData *cur = _content + y * _rW, *old = _flushed + y * _rW;
+
+			unsigned int x = 0;
+			while (x < _rW) {
+				while (x < _rW && cur[x] == old[x])
+					++x;
+				if (x == _rW)
+					break;
+
+				const unsigned int start = x;
+				unsigned int end = x + 1;
+				for (x = end; x < _rW && x - end <= kMaxRunGap; ++x) {
+					if (cur[x] != old[x])
+						end = x + 1;
+				}
+
+				flushRun(backend, start, y, end - start);
+				x = end;
+			}
 		}
 	}
+
+	_needsRefresh = false;
+}
+
+void Window::flushRun(Backend &backend, unsigned int x, unsigned int y, unsigned int length) {
+	const unsigned int offset = y * _rW + x;
+
+	backend.putRun(_rX + x, _rY + y, _content + offset, length);
+	std::memcpy(_flushed + offset, _content + offset, length * sizeof(CharData));
 }
 
 } // end of namespace Intern
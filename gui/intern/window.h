@@ -21,9 +21,9 @@
 #ifndef GUI_INTERN_WINDOW_H
 #define GUI_INTERN_WINDOW_H
 
-#include "gui/defs.h"
+#include "backend.h"
 
-#include <ncurses.h>
+#include "gui/defs.h"
 
 namespace GUI {
 namespace Intern {
@@ -33,9 +33,7 @@ friend class Screen;
 public:
 	/**
 	 * Creates a window with the given postion and size.
-	 * The right most coordinate is (Screen::width() - 1, y).
-	 * The down most coordinate is (x, Screen::height() - 1).
-	 * This results in the max width being Screen::width() and the max height being Screen::height().
+	 * The window must fit into the screen it is added to.
 	 *
 	 * @param x The x coordinate of the new window.
 	 * @param y The y cooridnate of the new window.
@@ -102,7 +100,7 @@ public:
 	 * @param attrib Output attributes.
 	 * @see GUI::Attributes
 	 */
-	void printChar(chtype ch, unsigned int x, unsigned int y, ColorPair color = kWhiteOnBlack, int attrib = kAttribNormal);
+	void printChar(CharData ch, unsigned int x, unsigned int y, ColorPair color = kWhiteOnBlack, int attrib = kAttribNormal);
 
 	/**
 	 * Returns the character data for the given character and it's attributes.
@@ -112,7 +110,9 @@ public:
 	 * @param attrib Output attributes.
 	 * @see GUI::Attributes
 	 */
-	static chtype getCharData(chtype ch, ColorPair color, int attrib = kAttribNormal) { return ch | COLOR_PAIR(color) | (chtype)attrib; }
+	static CharData getCharData(CharData ch, ColorPair color, int attrib = kAttribNormal) {
+		return ch | (static_cast<CharData>(color) << kCharDataColorShift) | static_cast<CharData>(attrib);
+	}
 
 	/**
 	 * Replaces a given part of the screen with the given data.
@@ -124,7 +124,7 @@ public:
 	 * @param data data to put
 	 * @param pitch pitch of the data
 	 */
-	void putData(unsigned int x, unsigned int y, unsigned int width, unsigned int height, const chtype *data, unsigned int pitch);
+	void putData(unsigned int x, unsigned int y, unsigned int width, unsigned int height, const CharData *data, unsigned int pitch);
 
 	/**
 	 * Clears the window. This will not remove the window's border!
@@ -133,12 +133,42 @@ public:
 private:
 	const unsigned int _x, _y, _w, _h;
 	const unsigned int _rX, _rY, _rW, _rH;
-	chtype *_content;
+	CharData *_content;
+
+	/**
+	 * The content as it was flushed to curses the last time.
+	 * This is used to only output changed cells.
+	 */
+	CharData *_flushed;
+
+	/**
+	 * Marks cells, which have never been flushed. No real
+	 * content ever matches this.
+	 */
+	static const CharData kUnflushedCell = ~static_cast<CharData>(0);
+
+	enum {
+		/**
+		 * Unchanged cells between two changed runs, up to which
+		 * both runs are output at once.
+		 */
+		kMaxRunGap = 4
+	};
+
+	/**
+	 * Outputs the given part of a line.
+	 *
+	 * @param backend Backend to output to.
+	 * @param x x coordinate in real window coordinates.
+	 * @param y y coordinate in real window coordinates.
+	 * @param length Number of cells to output.
+	 */
+	void flushRun(Backend &backend, unsigned int x, unsigned int y, unsigned int length);
 
 	bool _hasBorder;
 
 	bool _needsRefresh;
-	void redraw(bool force);
+	void redraw(Backend &backend, bool force);
 };
 
 } // end of namespace Intern
@@ -22,15 +22,31 @@
 
 #include <cassert>
 #include <sstream>
+#include <algorithm>
 
 #include <boost/foreach.hpp>
 
 namespace GUI {
 
-Screen::Screen(const Game::Monster &player)
-    : _screen(GUI::Intern::Screen::instance()), _input(GUI::Intern::Input::instance()), _messageLine(0),
-      _mapWindow(0), _playerStats(0), _keyMap(), _messages(), _turn(0), _player(player), _needRedraw(false),
-      _map(0), _monsters(), _centerX(0), _centerY(0), _mapOffsetX(0), _mapOffsetY(0), _monsterDrawDescs(0),
+namespace {
+
+/**
+ * The key, which starts a count prefix. Digits can not be used
+ * on their own, since they are the keypad directions.
+ */
+const int kKeyCount = 'c';
+
+/**
+ * The maximum count of a repeated command.
+ */
+const unsigned int kMaxRepeatCount = 9999;
+
+} // end of anonymous namespace
+
+Screen::Screen(const Game::Definitions &defs, GUI::Intern::Screen &screen, GUI::Intern::Input &input, const Game::Monster &player)
+    : _definitions(defs), _screen(screen), _input(input), _messageLine(0),
+      _mapWindow(0), _playerStats(0), _keyMap(), _repeatInput(kInputNone), _repeatCount(0), _readingCount(false), _count(0), _messages(), _messageText(), _lineText(), _moreShown(false), _turn(0), _player(player), _statsChanged(false), _statsHitPoints(0),
+      _needRedraw(false), _cursorMoved(false), _nextFrame(0), _frameTimeCap(0), _map(0), _fov(0), _dirtyCells(), _dirtyPlane(), _drawnView(), _drawnExplored(), _terrainLayer(), _rememberedLayer(), _viewLayer(), _composeView(false), _monsters(), _centerX(0), _centerY(0), _mapOffsetX(0), _mapOffsetY(0), _monsterDrawDescs(0),
       _mapDrawDescs(0) {
 }
 
@@ -48,49 +64,167 @@ Screen::~Screen() {
 
 void Screen::initialize() throw (Base::NonRecoverableException) {
 	if (!_mapDrawDescs) {
-		_mapDrawDescs = Intern::parseTileDefinitons("./data/gui/tiles.def");
-		_monsterDrawDescs = Intern::parseMonsterDefinitions("./data/gui/monster.def");
+		_mapDrawDescs = Intern::parseTileDefinitons("./data/gui/tiles.def", _definitions.getTileDatabase());
+		_monsterDrawDescs = Intern::parseMonsterDefinitions("./data/gui/monster.def", _definitions.getMonsterDatabase());
 		createOutputWindows();
 		setupKeyMap();
 	}
 }
 
 void Screen::update(bool drawMsg) {
-	if ((!_needRedraw || !_map) && !(drawMsg && !_messages.empty()))
+	const bool printMsg = drawMsg && !_messages.isEmpty();
+	if (!_map && !printMsg)
 		return;
-	_needRedraw = false;
 
-	drawStatsWindow();
+	if (_map) {
+		if (_composeView)
+			composeView();
+		flagViewChanges();
+	}
+
+	if (_player.getHitPoints() != _statsHitPoints)
+		_statsChanged = true;
+
+	if (!_needRedraw && _dirtyCells.empty() && !_statsChanged && !_cursorMoved && !printMsg)
+		return;
+
+	if (_needRedraw || _statsChanged)
+		drawStatsWindow();
+	_statsChanged = false;
 
 	if (drawMsg)
 		printMessages();
 
-	const unsigned int outputWidth = _mapWindow->getWidth(), outputHeight = _mapWindow->getHeight();
-	const unsigned int mapWidth = _map->getWidth(), mapHeight = _map->getHeight();
+	if (_map) {
+		if (_needRedraw) {
+			const unsigned int maxWidth = std::min(_mapWindow->getWidth(), _map->getWidth());
+			const unsigned int maxHeight = std::min(_mapWindow->getHeight(), _map->getHeight());
+
+			_mapWindow->putData(0, 0, maxWidth, maxHeight, &_viewLayer[_mapOffsetY * _map->getWidth() + _mapOffsetX], _map->getWidth());
+		} else {
+			BOOST_FOREACH(const Base::Point &p, _dirtyCells) {
+				if (isInView(p))
+					drawTerrain(p);
+			}
+		}
+
+		drawMonsters(!_needRedraw);
+
+		_screen.setCursor(*_mapWindow, _centerX - _mapOffsetX, _centerY - _mapOffsetY);
+	}
+
+	BOOST_FOREACH(const Base::Point &p, _dirtyCells)
+		_dirtyPlane.set(p._x, p._y, false);
+	_dirtyCells.clear();
+	_needRedraw = false;
+	_cursorMoved = false;
+
+	_screen.update();
+	_nextFrame = Base::Timer::getTime() + _frameTimeCap;
+}
+
+void Screen::updateTick() {
+	// Ticks, in which nothing changed, are not waited for. Most
+	// ticks pass without any monster acting.
+	if (!_frameTimeCap || !(_needRedraw || _cursorMoved || !_dirtyCells.empty()))
+		return;
+
+	Base::Timer::sleepUntil(_nextFrame);
+	update();
+}
 
-	const unsigned int maxWidth = std::min(outputWidth, mapWidth), maxHeight = std::min(outputHeight, mapHeight);
-	for (unsigned int y = 0; y < maxHeight; ++y) {
-		for (unsigned int x = 0; x < maxWidth; ++x) {
-			const Game::Tile tile = _map->tileAt(x + _mapOffsetX, y + _mapOffsetY);
-			const Intern::DrawDesc &desc = _mapDrawDescs->lookUp(tile);
-			_mapWindow->printChar(desc._symbol, x, y, desc._color, desc._attribs);
+void Screen::flagForUpdate(const Base::Point &p) {
+	if (!_map || static_cast<unsigned int>(p._x) >= _dirtyPlane.getWidth() || static_cast<unsigned int>(p._y) >= _dirtyPlane.getHeight())
+		return;
+
+	if (!_dirtyPlane.get(p._x, p._y)) {
+		_dirtyPlane.set(p._x, p._y);
+		_dirtyCells.push_back(p);
+	}
+}
+
+void Screen::flagTileChange(const Base::Point &p) {
+	if (!_map || static_cast<unsigned int>(p._x) >= _map->getWidth() || static_cast<unsigned int>(p._y) >= _map->getHeight())
+		return;
+
+	renderTerrain(p);
+	composeView(p);
+	flagForUpdate(p);
+}
+
+void Screen::flagViewChanges() {
+	if (!_fov) {
+		_drawnView.resize(0, 0);
+		_drawnExplored.resize(0, 0);
+		return;
+	}
+
+	const Base::BitPlane &view = _fov->getVisible();
+	const Base::BitPlane &explored = _fov->getExplored();
+	if (_drawnView.getWidth() != view.getWidth() || _drawnView.getHeight() != view.getHeight()) {
+		_drawnView = view;
+		_drawnExplored = explored;
+		_needRedraw = true;
+		composeView();
+		return;
+	}
+
+	// Compare the planes word by word, only the changed bits
+	// need to be looked at. This is also done, when the whole
+	// map is redrawn, since the view layer needs to be updated.
+	for (unsigned int y = 0; y < view.getHeight(); ++y) {
+		const Base::BitPlane::Word *cur = view.getRow(y), *old = _drawnView.getRow(y);
+		const Base::BitPlane::Word *curExplored = explored.getRow(y), *oldExplored = _drawnExplored.getRow(y);
+
+		for (unsigned int w = 0; w < view.getPitch(); ++w) {
+			Base::BitPlane::Word diff = (cur[w] ^ old[w]) | (curExplored[w] ^ oldExplored[w]);
+			for (unsigned int bit = 0; diff; ++bit, diff >>= 1) {
+				if (diff & 1) {
+					const Base::Point p(w * Base::BitPlane::kWordBits + bit, y);
+					composeView(p);
+					flagForUpdate(p);
+				}
+			}
 		}
 	}
 
+	_drawnView = view;
+	_drawnExplored = explored;
+}
+
+void Screen::renderTerrain(const Base::Point &p) {
+	const unsigned int i = p._y * _map->getWidth() + p._x;
+	const Intern::DrawDesc &desc = _mapDrawDescs->lookUp(_map->tileAt(p));
+
+	_terrainLayer[i] = Intern::Window::getCharData(desc._symbol, desc._color, desc._attribs);
+	_rememberedLayer[i] = Intern::Window::getCharData(desc._symbol, kBlueOnBlack, kAttribDim);
+}
+
+void Screen::composeView() {
+	for (unsigned int y = 0; y < _map->getHeight(); ++y) {
+		for (unsigned int x = 0; x < _map->getWidth(); ++x)
+			composeView(Base::Point(x, y));
+	}
+
+	_composeView = false;
+}
+
+void Screen::drawMonsters(bool dirtyOnly) {
 	BOOST_FOREACH(const MonsterList::value_type monster, _monsters) {
-		const unsigned int monsterX = monster->getX(), monsterY = monster->getY();
+		const Base::Point &p = monster->getPos();
 
-		if (monsterX < _mapOffsetX || monsterY < _mapOffsetY
-		    || monsterX >= _mapOffsetX + outputWidth
-		    || monsterY >= _mapOffsetY + outputHeight)
+		if (!isInView(p))
+			continue;
+
+		if (dirtyOnly && !_dirtyPlane.get(p._x, p._y))
+			continue;
+
+		if (_fov && !_fov->isVisible(p))
 			continue;
 
 		const Intern::DrawDesc &desc = _monsterDrawDescs->lookUp(monster->getType());
-		_mapWindow->printChar(desc._symbol, monsterX - _mapOffsetX, monsterY - _mapOffsetY, desc._color, desc._attribs);
+		_mapWindow->printChar(desc._symbol, p._x - _mapOffsetX, p._y - _mapOffsetY, desc._color, desc._attribs);
 	}
-
-	_screen.setCursor(*_mapWindow, _centerX - _mapOffsetX, _centerY - _mapOffsetY);
-	_screen.update();
 }
 
 void Screen::setCenter(unsigned int x, unsigned int y) {
@@ -108,30 +242,66 @@ void Screen::setCenter(unsigned int x, unsigned int y) {
 
 	offsetX = std::max(offsetX, 0);
 	offsetX = std::min(offsetX, static_cast<int>(mapWidth) - static_cast<int>(outputWidth));
-	_mapOffsetX = std::max(offsetX, 0);
 
 	offsetY = std::max(offsetY, 0);
 	offsetY = std::min(offsetY, static_cast<int>(mapHeight) - static_cast<int>(outputHeight));
-	_mapOffsetY = std::max(offsetY, 0);
+	offsetX = std::max(offsetX, 0);
+	offsetY = std::max(offsetY, 0);
 
-	_needRedraw = true;
+	// Only scrolling requires the whole map to be redrawn.
+	if (_mapOffsetX != static_cast<unsigned int>(offsetX) || _mapOffsetY != static_cast<unsigned int>(offsetY))
+		_needRedraw = true;
+
+	_mapOffsetX = offsetX;
+	_mapOffsetY = offsetY;
+	_cursorMoved = true;
 }
 
 void Screen::setMap(const Game::Map *map) {
 	_map = map;
 	flagForUpdate();
 	clearObjects();
+
+	_dirtyCells.clear();
+	if (_map) {
+		const unsigned int size = _map->getWidth() * _map->getHeight();
+
+		_dirtyPlane.resize(_map->getWidth(), _map->getHeight());
+		_terrainLayer.resize(size);
+		_rememberedLayer.resize(size);
+		_viewLayer.resize(size);
+
+		// The terrain is rendered only once here, afterwards
+		// only changed tiles need to be rendered again.
+		for (unsigned int y = 0; y < _map->getHeight(); ++y) {
+			for (unsigned int x = 0; x < _map->getWidth(); ++x)
+				renderTerrain(Base::Point(x, y));
+		}
+
+		_composeView = true;
+	} else {
+		_dirtyPlane.resize(0, 0);
+		_terrainLayer.clear();
+		_rememberedLayer.clear();
+		_viewLayer.clear();
+		_composeView = false;
+	}
 }
 
-void Screen::addObject(const Game::Monster *monster) {
+void Screen::setFieldOfView(const Game::FieldOfView *fov) {
+	_fov = fov;
+	_composeView = (_map != 0);
 	flagForUpdate();
+}
+
+void Screen::addObject(const Game::Monster *monster) {
 	remObject(monster);
 
 	_monsters.push_back(monster);
 }
 
 void Screen::remObject(const Game::Monster *monster) {
-	flagForUpdate();
+	flagForUpdate(monster->getPos());
 	_monsters.remove(monster);
 }
 
@@ -141,18 +311,74 @@ void Screen::clearObjects() {
 }
 
 Input Screen::getInput() {
-	while (true) {
-		int key = getKey();
-		KeyMap::const_iterator i = _keyMap.find(key);
-		if (i != _keyMap.end())
-			return i->second;
+	Input input = kInputNone;
+	while (!pollInput(input))
+		waitForInput();
+	return input;
+}
+
+bool Screen::pollInput(Input &input) {
+	while (hasPendingInput()) {
+		if (readInput(input))
+			return true;
 	}
+
+	return false;
+}
+
+bool Screen::readInput(Input &input) {
+	if (_repeatCount) {
+		--_repeatCount;
+		input = _repeatInput;
+		return true;
+	}
+
+	const int key = getKey();
+	if (!key)
+		return false;
+
+	// Any key continues showing the messages.
+	if (_moreShown) {
+		_moreShown = false;
+		update(true);
+		return false;
+	}
+
+	if (_readingCount) {
+		if (key >= '0' && key <= '9') {
+			_count = std::min(_count * 10 + static_cast<unsigned int>(key - '0'), kMaxRepeatCount);
+			return false;
+		}
+		_readingCount = false;
+	} else if (key == kKeyCount) {
+		_readingCount = true;
+		_count = 0;
+		return false;
+	}
+
+	const unsigned int count = _count;
+	_count = 0;
+
+	KeyMap::const_iterator i = _keyMap.find(key);
+	if (i == _keyMap.end())
+		return false;
+
+	if (count > 1) {
+		_repeatInput = i->second;
+		_repeatCount = count - 1;
+	}
+
+	input = i->second;
+	return true;
 }
 
 int Screen::getKey() {
 	int input = 0;
 
 	do {
+		if (!_input.hasPendingInput())
+			return 0;
+
 		input = _input.poll();
 
 		if (input == Intern::kNotifyResize) {
@@ -199,6 +425,8 @@ void Screen::setupKeyMap() {
 	_keyMap['u'] = kInputDir9;
 
 	_keyMap['/'] = kInputExamine;
+	_keyMap['_'] = kInputTravel;
+	_keyMap['R'] = kInputRest;
 	_keyMap[kKeyEscape] = kInputQuit;
 
 	_keyMap[' '] = kInputNone;
@@ -230,46 +458,87 @@ void Screen::createOutputWindows() {
 	_needRedraw = true;
 }
 
-void Screen::addToMsgWindow(const std::string &str) {
-	_messages.push_back(str);
-	_needRedraw = true;
-}
-
 void Screen::printMessages() {
+	// The messages are continued, once the user entered a key.
+	if (_moreShown)
+		return;
+
 	_messageLine->clear();
-	std::string line;
+	_lineText.clear();
 
-	while (!_messages.empty()) {
-		_messageLine->clear();
-		line.clear();
-		while (!_messages.empty()) {
-			std::string front = _messages.front();
-			if (!line.empty() && front.size() < _messageLine->getWidth()) {
-				if (line.size() + front.size() > _messageLine->getWidth() || (_messages.size() > 1 && line.size() + front.size() > _messageLine->getWidth() - 10))
+	if (!_messages.isEmpty()) {
+		while (!_messages.isEmpty()) {
+			_messageText.clear();
+			Game::formatMessage(_definitions, _messages.front(), _messageText);
+
+			if (!_lineText.empty() && _messageText.size() < _messageLine->getWidth()) {
+				if (_lineText.size() + _messageText.size() > _messageLine->getWidth() || (_messages.size() > 1 && _lineText.size() + _messageText.size() > _messageLine->getWidth() - 10))
 					break;
 			}
 
-			_messages.pop_front();
-			if (!line.empty())
-				line += "  ";
-			line += front;
+			_messages.popFront();
+			if (!_lineText.empty())
+				_lineText += "  ";
+			_lineText += _messageText;
 		}
 
-		if (!_messages.empty())
-			line += " -- more --";
+		if (!_messages.isEmpty()) {
+			_lineText += " -- more --";
+			_moreShown = true;
+		}
 
-		_messageLine->printLine(line.c_str(), 0, 0);
-		if (!_messages.empty()) {
-			_screen.update();
-			_input.poll();
+		_messageLine->printLine(_lineText.c_str(), 0, 0);
+	}
+}
+
+void Screen::syncState(Base::Serializer &s) {
+	s.syncEnum(_repeatInput, kInputRest);
+	s.syncUint(_repeatCount);
+	s.syncBool(_readingCount);
+	s.syncUint(_count);
+
+	unsigned int count = static_cast<unsigned int>(_messages.size());
+	s.syncCount(count, 3);
+	if (s.isLoading())
+		_messages.clear();
+
+	for (unsigned int i = 0; i < count; ++i) {
+		Game::Message msg = s.isSaving() ? _messages[i] : Game::Message();
+		s.syncEnum(msg._template, static_cast<Game::MessageTemplate>(Game::kMsgTemplateCount - 1));
+		s.syncUint(msg._args[0]);
+		s.syncUint(msg._args[1]);
+
+		if (s.isLoading()) {
+			if (!Game::isValidMessage(_definitions, msg))
+				throw Base::Serializer::Exception("Invalid message");
+			_messages.pushBack(msg);
 		}
 	}
+
+	s.syncString(_lineText);
+	s.syncBool(_moreShown);
+	s.syncUint(_turn);
+
+	unsigned int centerX = _centerX, centerY = _centerY;
+	s.syncUint(centerX);
+	s.syncUint(centerY);
+
+	if (s.isLoading()) {
+		if (!_map || centerX >= _map->getWidth() || centerY >= _map->getHeight())
+			throw Base::Serializer::Exception("Screen center outside the map");
+
+		setCenter(centerX, centerY);
+		_statsChanged = true;
+
+		_messageLine->clear();
+		_messageLine->printLine(_lineText.c_str(), 0, 0);
+	}
 }
 
 void Screen::setTurn(unsigned int turn) {
 	if (_turn != turn) {
 		_turn = turn;
-		_needRedraw = true;
+		_statsChanged = true;
 	}
 }
 
@@ -284,6 +553,7 @@ void Screen::drawStatsWindow() {
 	     << " | " << "HP: " << _player.getHitPoints() << "/" << _player.getMaxHitPoints()
 	     << " | T: " << _turn;
 
+	_statsHitPoints = _player.getHitPoints();
 	_playerStats->clear();
 	_playerStats->printLine(line.str().c_str(), 0, 0);
 }
@@ -27,20 +27,36 @@
 #include "intern/drawdesc.h"
 
 #include "game/map.h"
+#include "game/fov.h"
 #include "game/monster.h"
+#include "game/message.h"
+#include "game/definitions.h"
 
 #include "base/geo.h"
+#include "base/bitplane.h"
+#include "base/timer.h"
+#include "base/ringbuffer.h"
+#include "base/serializer.h"
 
 #include <list>
 #include <vector>
 #include <string>
 #include <map>
+#include <algorithm>
 
 namespace GUI {
 
 class Screen {
 public:
-	Screen(const Game::Monster &player);
+	/**
+	 * Constructor for the game screen.
+	 *
+	 * @param defs Definitions of the game.
+	 * @param screen Screen to draw on.
+	 * @param input Input to read the user's commands from.
+	 * @param player The player monster.
+	 */
+	Screen(const Game::Definitions &defs, GUI::Intern::Screen &screen, GUI::Intern::Input &input, const Game::Monster &player);
 	~Screen();
 
 	/**
@@ -50,14 +66,57 @@ public:
 
 	/**
 	 * Tells the game screen some object state changed.
+	 *
+	 * This results in the whole screen being redrawn.
 	 */
 	void flagForUpdate() { _needRedraw = true; }
 
+	/**
+	 * Tells the game screen the given map cell changed.
+	 *
+	 * Only the flagged cells are redrawn on the next
+	 * update, unless the whole screen needs a redraw.
+	 *
+	 * @param p Position of the cell (in map coordinates).
+	 */
+	void flagForUpdate(const Base::Point &p);
+
+	/**
+	 * Tells the game screen the tile of the given map cell changed.
+	 *
+	 * This renders the cell's terrain again and flags the
+	 * cell for update.
+	 *
+	 * @param p Position of the cell (in map coordinates).
+	 */
+	void flagTileChange(const Base::Point &p);
+
 	/**
 	 * Updates the game screen (when needed).
 	 */
 	void update(bool drawMsg = false);
 
+	/**
+	 * Updates the game screen for a tick, in which the player
+	 * can not act.
+	 *
+	 * Such ticks are only drawn, when a frame time cap is set
+	 * and anything on the map changed. Before drawing, this waits
+	 * until the last frame is at least the cap old, thus watching
+	 * the monsters' moves is not faster than the frame rate.
+	 *
+	 * @see setFrameTimeCap
+	 */
+	void updateTick();
+
+	/**
+	 * Sets the time between two frames drawn for ticks, in which
+	 * the player can not act.
+	 *
+	 * @param cap Time in microseconds (0 to not draw such ticks at all).
+	 */
+	void setFrameTimeCap(uint64_t cap) { _frameTimeCap = cap; }
+
 	/**
 	 * Sets the map to draw upon.
 	 *
@@ -68,6 +127,19 @@ public:
 	 */
 	void setMap(const Game::Map *map);
 
+	/**
+	 * Sets the field of view of the player.
+	 *
+	 * When set, only the visible part of the map and the monsters
+	 * in it are drawn. Explored tiles outside the field of view
+	 * are drawn dimmed, all others are left blank.
+	 *
+	 * This automatically updates the refresh flag!
+	 *
+	 * @param fov The field of view (0 to draw everything).
+	 */
+	void setFieldOfView(const Game::FieldOfView *fov);
+
 	/**
 	 * Sets the position, which should be centered.
 	 *
@@ -88,7 +160,7 @@ public:
 	/**
 	 * Adds a monster to the display object list.
 	 *
-	 * This automatically updates the refresh flag!
+	 * This automatically flags the monster's position for update!
 	 *
 	 * @param monster The monster to draw.
 	 */
@@ -97,7 +169,7 @@ public:
 	/**
 	 * Removes a monster from the display object list.
 	 *
-	 * This automatically updates the refresh flag!
+	 * This automatically flags the monster's position for update!
 	 *
 	 * @param monster The monster to remove.
 	 */
@@ -113,9 +185,15 @@ public:
 	/**
 	 * Adds a message to the message window.
 	 *
-	 * @param str Message to add.
+	 * The message's text is only formatted, when it is shown.
+	 * This also stops any repeated command.
+	 *
+	 * @param msg Message to add.
 	 */
-	void addToMsgWindow(const std::string &str);
+	void addToMsgWindow(const Game::Message &msg) {
+		_messages.pushBack(msg);
+		_repeatCount = 0;
+	}
 
 	/**
 	 * Sets the current turn.
@@ -125,13 +203,67 @@ public:
 	void setTurn(unsigned int turn);
 
 	/**
-	 * Waits for the user to enter any key.
+	 * Waits for the user to enter a command.
 	 *
-	 * @see Input
+	 * @see pollInput
 	 * @return User's input.
 	 */
 	Input getInput();
+
+	/**
+	 * Returns a command the user entered already, without waiting.
+	 *
+	 * A command can be prefixed by 'c' and a count, for example
+	 * "c20.", to repeat it that many times. The repetition stops,
+	 * when a message is added.
+	 *
+	 * When a message is shown with "-- more --", the next key only
+	 * continues showing the messages.
+	 *
+	 * Keys, which do not complete a command, are remembered, thus
+	 * the command can be completed by the next call.
+	 *
+	 * @see Input
+	 * @param input Where to store the user's input.
+	 * @return true when there was input, false otherwise.
+	 */
+	bool pollInput(Input &input);
+
+	/**
+	 * Waits until the user entered anything, which can be
+	 * processed by pollInput.
+	 */
+	void waitForInput() {
+		if (!hasPendingInput())
+			_input.waitForInput();
+	}
+
+	/**
+	 * Checks whether there is input, which can be processed
+	 * without waiting for the user. This includes keys typed
+	 * ahead and repeated commands.
+	 *
+	 * @return true when input is pending, false otherwise.
+	 */
+	bool hasPendingInput() { return _repeatCount || _input.hasPendingInput(); }
+
+	/**
+	 * Checks whether there are messages, which were not shown yet.
+	 *
+	 * @return true when messages are pending, false otherwise.
+	 */
+	bool hasPendingMessages() const { return !_messages.isEmpty(); }
+
+	/**
+	 * Saves or restores the messages, the input state and the
+	 * center of the screen. When restoring, the map must be set
+	 * already.
+	 *
+	 * @param s Serializer to use.
+	 */
+	void syncState(Base::Serializer &s);
 private:
+	const Game::Definitions &_definitions;
 	GUI::Intern::Screen &_screen;
 	GUI::Intern::Input &_input;
 
@@ -139,24 +271,176 @@ private:
 	GUI::Intern::Window *_mapWindow;
 	GUI::Intern::Window *_playerStats;
 
+	/**
+	 * Reads a key the user entered already.
+	 *
+	 * @return key, 0 when there is none.
+	 */
 	int getKey();
+
+	/**
+	 * Processes a key the user entered already.
+	 *
+	 * @param input Where to store the command.
+	 * @return true when a command was completed, false otherwise.
+	 */
+	bool readInput(Input &input);
 	typedef std::map<int, Input> KeyMap;
 	KeyMap _keyMap;
 
 	void setupKeyMap();
 
+	/**
+	 * The command to repeat and how often it still needs to
+	 * be repeated.
+	 */
+	Input _repeatInput;
+	unsigned int _repeatCount;
+
+	/**
+	 * Whether a count prefix is entered and the count entered
+	 * so far.
+	 */
+	bool _readingCount;
+	unsigned int _count;
+
 	void createOutputWindows();
 
-	typedef std::list<std::string> StringList;
-	StringList _messages;
+	/**
+	 * The messages, which were not shown yet. When more messages
+	 * pile up, the oldest ones are dropped.
+	 */
+	typedef Base::RingBuffer<Game::Message, 64> MessageBuffer;
+	MessageBuffer _messages;
+
+	/**
+	 * The text of the message currently formatted and of the
+	 * message line as shown. These are kept, so their memory
+	 * is reused.
+	 */
+	std::string _messageText, _lineText;
+
+	/**
+	 * Whether a message line with "-- more --" is shown, which
+	 * waits for a key.
+	 */
+	bool _moreShown;
+
 	void printMessages();
 
 	unsigned int _turn;
 	const Game::Monster &_player;
+	bool _statsChanged;
+	int _statsHitPoints;
 	void drawStatsWindow();
 
 	bool _needRedraw;
+	bool _cursorMoved;
+
+	/**
+	 * The time, when the next frame for a tick may be drawn.
+	 */
+	uint64_t _nextFrame;
+	uint64_t _frameTimeCap;
+
 	const Game::Map *_map;
+	const Game::FieldOfView *_fov;
+
+	/**
+	 * All map cells flagged for update. Every cell is only
+	 * listed once, which is assured by the dirty plane.
+	 */
+	typedef std::vector<Base::Point> PointList;
+	PointList _dirtyCells;
+	Base::BitPlane _dirtyPlane;
+
+	/**
+	 * The visible and explored cells of the field of view,
+	 * when the map was drawn last.
+	 */
+	Base::BitPlane _drawnView;
+	Base::BitPlane _drawnExplored;
+
+	/**
+	 * Flags all cells, which changed their visibility since
+	 * the map was drawn last, and composes their view layer.
+	 */
+	void flagViewChanges();
+
+	/**
+	 * The terrain of the whole map as it is drawn, when the
+	 * cell is visible. It is organized line-wise like the map.
+	 */
+	typedef std::vector<CharData> CharLayer;
+	CharLayer _terrainLayer;
+
+	/**
+	 * The terrain of the whole map as it is drawn, when the
+	 * cell was explored, but is not visible right now.
+	 */
+	CharLayer _rememberedLayer;
+
+	/**
+	 * The terrain of the whole map with the field of view
+	 * applied. This is what is actually put into the map window.
+	 */
+	CharLayer _viewLayer;
+
+	/**
+	 * Whether the whole view layer needs to be composed again.
+	 */
+	bool _composeView;
+
+	/**
+	 * Renders the terrain of the given cell into the terrain
+	 * layers.
+	 *
+	 * @param p Position of the cell.
+	 */
+	void renderTerrain(const Base::Point &p);
+
+	/**
+	 * Composes the view layer of the given cell.
+	 *
+	 * @param p Position of the cell.
+	 */
+	void composeView(const Base::Point &p) {
+		const unsigned int i = p._y * _map->getWidth() + p._x;
+
+		if (!_fov || _fov->isVisible(p))
+			_viewLayer[i] = _terrainLayer[i];
+		else if (_fov->isExplored(p))
+			_viewLayer[i] = _rememberedLayer[i];
+		else
+			_viewLayer[i] = ' ';
+	}
+
+	/**
+	 * Composes the whole view layer.
+	 */
+	void composeView();
+
+	/**
+	 * Draws the terrain of the given cell.
+	 *
+	 * @param p Position of the cell (must be inside the view).
+	 */
+	void drawTerrain(const Base::Point &p) {
+		_mapWindow->putData(p._x - _mapOffsetX, p._y - _mapOffsetY, 1, 1, &_viewLayer[p._y * _map->getWidth() + p._x], 1);
+	}
+
+	/**
+	 * Draws all monsters.
+	 *
+	 * @param dirtyOnly Whether only monsters on flagged cells should be drawn.
+	 */
+	void drawMonsters(bool dirtyOnly);
+
+	bool isInView(const Base::Point &p) const {
+		return static_cast<unsigned int>(p._x) >= _mapOffsetX && static_cast<unsigned int>(p._y) >= _mapOffsetY
+		    && static_cast<unsigned int>(p._x) < _mapOffsetX + std::min(_mapWindow->getWidth(), _map->getWidth())
+		    && static_cast<unsigned int>(p._y) < _mapOffsetY + std::min(_mapWindow->getHeight(), _map->getHeight());
+	}
 
 	typedef std::list<const Game::Monster *> MonsterList;
 	MonsterList _monsters;
@@ -0,0 +1,351 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "host.h"
+#include "session.h"
+
+#include "base/timer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+namespace Server {
+
+namespace {
+
+/**
+ * How many events are processed per wake up of the loop.
+ */
+const int kMaxEvents = 64;
+
+/**
+ * Creates an error message for the last failed system call.
+ */
+std::string systemError(const std::string &call) {
+	return call + ": " + std::strerror(errno);
+}
+
+} // end of anonymous namespace
+
+int Host::_wakeupFd = -1;
+volatile sig_atomic_t Host::_stop = 0;
+
+Host::Host(boost::shared_ptr<const Game::Definitions> defs, uint32_t seed) throw (Base::NonRecoverableException)
+    : _definitions(defs), _nextSeed(seed), _epoll(-1), _listeners(), _unixPath(), _sessions(), _scheduler(), _hibernationTime(0), _nextIdleCheck(0), _snapshotDirectory(), _heldEscapes(), _finishedMutex(), _finished() {
+	_epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (_epoll < 0)
+		throw Base::NonRecoverableException(systemError("epoll_create1"));
+
+	_wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_wakeupFd < 0) {
+		close(_epoll);
+		throw Base::NonRecoverableException(systemError("eventfd"));
+	}
+
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = _wakeupFd;
+	epoll_ctl(_epoll, EPOLL_CTL_ADD, _wakeupFd, &event);
+}
+
+Host::~Host() {
+	for (std::vector<int>::iterator i = _listeners.begin(); i != _listeners.end(); ++i)
+		close(*i);
+	if (!_unixPath.empty())
+		unlink(_unixPath.c_str());
+
+	close(_wakeupFd);
+	_wakeupFd = -1;
+	close(_epoll);
+}
+
+void Host::listenTCP(unsigned short port) throw (Base::NonRecoverableException) {
+	const int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listener < 0)
+		throw Base::NonRecoverableException(systemError("socket"));
+
+	const int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	sockaddr_in address;
+	std::memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+		close(listener);
+		throw Base::NonRecoverableException(systemError("bind"));
+	}
+
+	addListener(listener);
+}
+
+void Host::listenUnix(const std::string &path) throw (Base::NonRecoverableException) {
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	if (path.size() >= sizeof(address.sun_path))
+		throw Base::NonRecoverableException("Socket path too long: \"" + path + "\"");
+	address.sun_family = AF_UNIX;
+	std::strcpy(address.sun_path, path.c_str());
+
+	const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listener < 0)
+		throw Base::NonRecoverableException(systemError("socket"));
+
+	if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+		close(listener);
+		throw Base::NonRecoverableException(systemError("bind"));
+	}
+
+	_unixPath = path;
+	addListener(listener);
+}
+
+void Host::setHibernation(unsigned int idleTime, const std::string &directory) {
+	_hibernationTime = static_cast<uint64_t>(idleTime) * 1000000;
+	_snapshotDirectory = directory;
+}
+
+void Host::addListener(int listener) throw (Base::NonRecoverableException) {
+	if (listen(listener, SOMAXCONN) != 0) {
+		close(listener);
+		throw Base::NonRecoverableException(systemError("listen"));
+	}
+
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = listener;
+	epoll_ctl(_epoll, EPOLL_CTL_ADD, listener, &event);
+
+	_listeners.push_back(listener);
+}
+
+void Host::run() throw (Base::NonRecoverableException) {
+	struct sigaction action;
+	std::memset(&action, 0, sizeof(action));
+	action.sa_handler = &Host::handleStop;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, 0);
+	sigaction(SIGTERM, &action, 0);
+
+	// A player closing the connection must not kill the host,
+	// writing to the connection just fails instead.
+	signal(SIGPIPE, SIG_IGN);
+
+	epoll_event events[kMaxEvents];
+	while (!_stop) {
+		// Idle sessions are checked about every second, escapes
+		// held back after the escape delay.
+		int timeout = _hibernationTime ? 1000 : -1;
+		if (!_heldEscapes.empty())
+			timeout = Session::kEscapeDelay / 1000;
+
+		const int count = epoll_wait(_epoll, events, kMaxEvents, timeout);
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+			throw Base::NonRecoverableException(systemError("epoll_wait"));
+		}
+
+		for (int i = 0; i < count; ++i) {
+			const int fd = events[i].data.fd;
+
+			if (fd == _wakeupFd) {
+				uint64_t value;
+				if (read(_wakeupFd, &value, sizeof(value)) < 0) {
+					// Another wake up might have reset it already.
+				}
+				removeFinishedSessions();
+			} else if (std::find(_listeners.begin(), _listeners.end(), fd) != _listeners.end()) {
+				acceptConnection(fd);
+			} else {
+				const SessionMap::iterator session = _sessions.find(fd);
+				if (session == _sessions.end())
+					continue;
+
+				if (events[i].events & EPOLLOUT)
+					session->second->sendOutput();
+				if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+					readConnection(*session->second);
+			}
+		}
+
+		releaseEscapes();
+
+		if (_hibernationTime)
+			hibernateIdleSessions();
+	}
+
+	stopSessions();
+
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+}
+
+void Host::stopSessions() {
+	for (std::vector<int>::iterator i = _listeners.begin(); i != _listeners.end(); ++i)
+		epoll_ctl(_epoll, EPOLL_CTL_DEL, *i, 0);
+
+	// Make all games quit. The connections are shut down, so
+	// no more input is read and no more output is sent.
+	for (SessionMap::iterator i = _sessions.begin(); i != _sessions.end(); ++i) {
+		epoll_ctl(_epoll, EPOLL_CTL_DEL, i->first, 0);
+		shutdown(i->first, SHUT_RDWR);
+		i->second->close();
+	}
+
+	epoll_event event;
+	while (!_sessions.empty()) {
+		if (epoll_wait(_epoll, &event, 1, -1) <= 0)
+			continue;
+
+		uint64_t value;
+		if (read(_wakeupFd, &value, sizeof(value)) < 0) {
+			// Another wake up might have reset it already.
+		}
+		removeFinishedSessions();
+	}
+}
+
+void Host::hibernateIdleSessions() {
+	const uint64_t now = Base::Timer::getTime();
+	if (now < _nextIdleCheck)
+		return;
+	_nextIdleCheck = now + 1000000;
+
+	for (SessionMap::iterator i = _sessions.begin(); i != _sessions.end(); ++i) {
+		if (now - i->second->getLastInputTime() >= _hibernationTime)
+			i->second->hibernate();
+	}
+}
+
+void Host::releaseEscapes() {
+	const uint64_t now = Base::Timer::getTime();
+
+	for (std::set<int>::iterator i = _heldEscapes.begin(); i != _heldEscapes.end();) {
+		const SessionMap::iterator session = _sessions.find(*i);
+		if (session == _sessions.end() || !session->second->releaseEscape(now))
+			_heldEscapes.erase(i++);
+		else
+			++i;
+	}
+}
+
+void Host::handleStop(int) {
+	_stop = 1;
+	wakeUp();
+}
+
+void Host::wakeUp() {
+	const uint64_t value = 1;
+	if (write(_wakeupFd, &value, sizeof(value)) < 0) {
+		// The counter overflowing is just fine, the loop
+		// will wake up in that case anyway.
+	}
+}
+
+void Host::sessionFinished(Session &session) {
+	boost::lock_guard<boost::mutex> lock(_finishedMutex);
+	_finished.push_back(&session);
+	wakeUp();
+}
+
+void Host::waitForSend(Session &session, bool wait) {
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = wait ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+	event.data.fd = session.getSocket();
+
+	// This fails, when the connection was closed already, and
+	// the output is not needed anymore then.
+	epoll_ctl(_epoll, EPOLL_CTL_MOD, session.getSocket(), &event);
+}
+
+void Host::acceptConnection(int listener) {
+	const int socket = accept4(listener, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (socket < 0)
+		return;
+
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = socket;
+	if (epoll_ctl(_epoll, EPOLL_CTL_ADD, socket, &event) != 0) {
+		close(socket);
+		return;
+	}
+
+	Session *session = new Session(*this, _scheduler, socket, _definitions, _nextSeed++);
+	_sessions[socket] = session;
+	session->start();
+}
+
+void Host::readConnection(Session &session) {
+	unsigned char buffer[512];
+	const ssize_t result = read(session.getSocket(), buffer, sizeof(buffer));
+
+	if (result > 0) {
+		session.addInput(buffer, static_cast<unsigned int>(result));
+		if (session.isHoldingEscape())
+			_heldEscapes.insert(session.getSocket());
+	} else if (result == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+		// The socket stays open until the game finished, since
+		// the game still writes to it.
+		epoll_ctl(_epoll, EPOLL_CTL_DEL, session.getSocket(), 0);
+		session.close();
+	}
+}
+
+void Host::removeFinishedSessions() {
+	std::vector<Session *> finished;
+	{
+		boost::lock_guard<boost::mutex> lock(_finishedMutex);
+		finished.swap(_finished);
+	}
+
+	for (std::vector<Session *>::iterator i = finished.begin(); i != finished.end(); ++i)
+		removeSession(*i);
+}
+
+void Host::removeSession(Session *session) {
+	const int socket = session->getSocket();
+
+	_sessions.erase(socket);
+	_heldEscapes.erase(socket);
+
+	epoll_ctl(_epoll, EPOLL_CTL_DEL, socket, 0);
+	close(socket);
+	delete session;
+}
+
+} // end of namespace Server
+
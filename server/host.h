@@ -0,0 +1,189 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef SERVER_HOST_H
+#define SERVER_HOST_H
+
+#include "scheduler.h"
+
+#include "game/definitions.h"
+
+#include "base/exception.h"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+
+#include <stdint.h>
+#include <signal.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace Server {
+
+class Session;
+
+/**
+ * A host for the games of many players in one process.
+ *
+ * The host accepts connections on local TCP or Unix sockets and
+ * starts a session for every connection. All connections are
+ * multiplexed on one epoll loop, which passes the players' input
+ * to their sessions. The sessions are run by a scheduler, which
+ * only needs a few threads for all of them. The definitions are
+ * shared by all sessions.
+ *
+ * There may only be one host per process, since it stops on
+ * SIGINT and SIGTERM.
+ */
+class Host {
+public:
+	/**
+	 * Creates a host.
+	 *
+	 * @param defs Definitions of the games.
+	 * @param seed Seed of the first game, every further game uses the next seed.
+	 */
+	Host(boost::shared_ptr<const Game::Definitions> defs, uint32_t seed) throw (Base::NonRecoverableException);
+	~Host();
+
+	/**
+	 * Accepts connections on the given TCP port of the local host.
+	 *
+	 * @param port Port to listen on.
+	 */
+	void listenTCP(unsigned short port) throw (Base::NonRecoverableException);
+
+	/**
+	 * Accepts connections on a Unix socket.
+	 *
+	 * @param path Path of the socket, it is removed when the host stops.
+	 */
+	void listenUnix(const std::string &path) throw (Base::NonRecoverableException);
+
+	/**
+	 * Lets sessions hibernate, when their players are idle for
+	 * the given time. Their games are saved to snapshot files
+	 * then and restored, once the players enter anything.
+	 *
+	 * @param idleTime Idle time in seconds (0 to never hibernate).
+	 * @param directory Directory to store the snapshots in.
+	 */
+	void setHibernation(unsigned int idleTime, const std::string &directory);
+
+	/**
+	 * Returns the directory the snapshots are stored in.
+	 *
+	 * @return directory.
+	 */
+	const std::string &getSnapshotDirectory() const { return _snapshotDirectory; }
+
+	/**
+	 * Runs the host until SIGINT or SIGTERM is received. All games
+	 * still running are quit then.
+	 */
+	void run() throw (Base::NonRecoverableException);
+
+	/**
+	 * Tells the host a session's game finished. This may be
+	 * called from any thread.
+	 *
+	 * @param session Session, which finished.
+	 */
+	void sessionFinished(Session &session);
+
+	/**
+	 * Tells the host whether a session has output left, which
+	 * did not fit into its connection. The host sends it, once
+	 * the connection is ready. This may be called from any thread.
+	 *
+	 * @param session Session with output left.
+	 * @param wait Whether there is output left.
+	 */
+	void waitForSend(Session &session, bool wait);
+private:
+	Host(const Host &);
+	Host &operator=(const Host &);
+
+	const boost::shared_ptr<const Game::Definitions> _definitions;
+	uint32_t _nextSeed;
+
+	int _epoll;
+	std::vector<int> _listeners;
+	std::string _unixPath;
+
+	/**
+	 * All sessions, mapped by the socket of their connection.
+	 */
+	typedef std::map<int, Session *> SessionMap;
+	SessionMap _sessions;
+
+	Scheduler _scheduler;
+
+	/**
+	 * After how many microseconds idle sessions hibernate (0 to
+	 * never hibernate) and when they are checked next.
+	 */
+	uint64_t _hibernationTime;
+	uint64_t _nextIdleCheck;
+	std::string _snapshotDirectory;
+
+	void hibernateIdleSessions();
+
+	/**
+	 * The sockets of all sessions, which hold an escape back.
+	 */
+	std::set<int> _heldEscapes;
+
+	/**
+	 * Passes the escapes held back for long enough to the games.
+	 */
+	void releaseEscapes();
+
+	/**
+	 * The sessions, which finished their game. They are removed
+	 * by the loop.
+	 */
+	boost::mutex _finishedMutex;
+	std::vector<Session *> _finished;
+
+	/**
+	 * An eventfd to wake up the loop, when a session finished
+	 * or the host should stop.
+	 */
+	static int _wakeupFd;
+	static volatile sig_atomic_t _stop;
+	static void handleStop(int);
+	static void wakeUp();
+
+	void addListener(int listener) throw (Base::NonRecoverableException);
+	void acceptConnection(int listener);
+	void readConnection(Session &session);
+	void stopSessions();
+	void removeFinishedSessions();
+	void removeSession(Session *session);
+};
+
+} // end of namespace Server
+
+#endif
+
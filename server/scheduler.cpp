@@ -0,0 +1,77 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "scheduler.h"
+#include "session.h"
+
+#include <boost/bind/bind.hpp>
+
+namespace Server {
+
+Scheduler::Scheduler(unsigned int threads) : _mutex(), _sessionAvailable(), _queue(), _stop(false), _threads() {
+	if (!threads)
+		threads = boost::thread::hardware_concurrency();
+	if (!threads)
+		threads = 1;
+
+	for (unsigned int i = 0; i < threads; ++i)
+		_threads.create_thread(boost::bind(&Scheduler::workerLoop, this));
+}
+
+Scheduler::~Scheduler() {
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_sessionAvailable.notify_all();
+	_threads.join_all();
+}
+
+void Scheduler::schedule(Session &session) {
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		_queue.push_back(&session);
+	}
+
+	_sessionAvailable.notify_one();
+}
+
+void Scheduler::workerLoop() {
+	while (true) {
+		Session *session;
+		{
+			boost::unique_lock<boost::mutex> lock(_mutex);
+			while (_queue.empty() && !_stop)
+				_sessionAvailable.wait(lock);
+
+			if (_queue.empty())
+				return;
+
+			session = _queue.front();
+			_queue.pop_front();
+		}
+
+		session->resume();
+	}
+}
+
+} // end of namespace Server
+
@@ -0,0 +1,89 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef SERVER_SCHEDULER_H
+#define SERVER_SCHEDULER_H
+
+#include <deque>
+
+#include <boost/thread.hpp>
+
+namespace Server {
+
+class Session;
+
+/**
+ * Runs the sessions of a host on a few threads.
+ *
+ * A session is scheduled, when there is anything for its game
+ * to process. The game then runs until it needs input again,
+ * thus a thread is never blocked by a session, which waits for
+ * its player.
+ */
+class Scheduler {
+public:
+	/**
+	 * Creates a scheduler and starts its threads.
+	 *
+	 * @param threads Number of threads (0 to use one per core).
+	 */
+	explicit Scheduler(unsigned int threads = 0);
+
+	/**
+	 * Stops the threads. All sessions scheduled must have been
+	 * run already.
+	 */
+	~Scheduler();
+
+	/**
+	 * Returns the number of threads of the scheduler.
+	 *
+	 * @return thread count.
+	 */
+	unsigned int getThreadCount() const { return static_cast<unsigned int>(_threads.size()); }
+
+	/**
+	 * Schedules a session to be run. A session may only be
+	 * scheduled again, once it was run.
+	 *
+	 * @param session Session to run.
+	 */
+	void schedule(Session &session);
+private:
+	Scheduler(const Scheduler &);
+	Scheduler &operator=(const Scheduler &);
+
+	boost::mutex _mutex;
+	boost::condition_variable _sessionAvailable;
+	std::deque<Session *> _queue;
+	bool _stop;
+
+	boost::thread_group _threads;
+
+	/**
+	 * Runs the scheduled sessions until the scheduler is stopped.
+	 */
+	void workerLoop();
+};
+
+} // end of namespace Server
+
+#endif
+
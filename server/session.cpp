@@ -0,0 +1,369 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "session.h"
+#include "scheduler.h"
+#include "host.h"
+
+#include "base/timer.h"
+
+#include <cstdio>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/socket.h>
+
+namespace Server {
+
+Session::Session(Host &host, Scheduler &scheduler, int socket, boost::shared_ptr<const Game::Definitions> defs, uint32_t seed)
+    : _host(host), _scheduler(scheduler), _socket(socket), _definitions(defs), _seed(seed), _screen(0), _input(0), _game(0), _output(),
+      _snapshotPath(), _lastInputTime(Base::Timer::getTime()), _idle(false), _escapeHeld(false), _escapeTime(0), _mutex(), _received(), _sendBuffer(), _closed(false), _scheduled(false),
+      _finished(false), _hibernate(false), _waitingForSend(false) {
+}
+
+Session::~Session() {
+	destroyGame();
+	removeSnapshot();
+}
+
+void Session::start() {
+	boost::lock_guard<boost::mutex> lock(_mutex);
+	scheduleLocked();
+}
+
+void Session::addInput(const unsigned char *data, unsigned int length) {
+	_lastInputTime = Base::Timer::getTime();
+	_idle = false;
+
+	// The escape key and the start of an escape sequence can not be
+	// told apart, when a sequence is split across two reads. Thus an
+	// escape at the end is only passed on with the following input
+	// or once it is held back for long enough.
+	const bool holdEscape = length && data[length - 1] == GUI::kKeyEscape;
+	if (holdEscape)
+		--length;
+
+	boost::lock_guard<boost::mutex> lock(_mutex);
+	_hibernate = false;
+
+	if (_escapeHeld) {
+		const unsigned char escape = GUI::kKeyEscape;
+		receiveLocked(&escape, 1);
+	}
+	receiveLocked(data, length);
+
+	_escapeHeld = holdEscape;
+	_escapeTime = _lastInputTime;
+
+	if (!_received.empty())
+		scheduleLocked();
+}
+
+bool Session::releaseEscape(uint64_t now) {
+	if (!_escapeHeld)
+		return false;
+	if (now - _escapeTime < kEscapeDelay)
+		return true;
+
+	_escapeHeld = false;
+
+	boost::lock_guard<boost::mutex> lock(_mutex);
+	const unsigned char escape = GUI::kKeyEscape;
+	receiveLocked(&escape, 1);
+	scheduleLocked();
+	return false;
+}
+
+void Session::close() {
+	boost::lock_guard<boost::mutex> lock(_mutex);
+
+	// Nothing follows an escape held back anymore.
+	if (_escapeHeld) {
+		const unsigned char escape = GUI::kKeyEscape;
+		receiveLocked(&escape, 1);
+		_escapeHeld = false;
+	}
+
+	_closed = true;
+	scheduleLocked();
+}
+
+void Session::hibernate() {
+	if (_idle)
+		return;
+	_idle = true;
+
+	boost::lock_guard<boost::mutex> lock(_mutex);
+
+	if (!_received.empty() || _closed)
+		return;
+
+	_hibernate = true;
+	scheduleLocked();
+}
+
+bool Session::readInput(unsigned char &input) {
+	boost::lock_guard<boost::mutex> lock(_mutex);
+
+	if (_received.empty())
+		return false;
+
+	input = _received.front();
+	_received.pop_front();
+	return true;
+}
+
+bool Session::isClosed() {
+	boost::lock_guard<boost::mutex> lock(_mutex);
+	return _closed;
+}
+
+void Session::receiveLocked(const unsigned char *data, unsigned int length) {
+	if (_received.size() + length > kMaxInput)
+		length = static_cast<unsigned int>(kMaxInput - _received.size());
+	_received.insert(_received.end(), data, data + length);
+}
+
+void Session::scheduleLocked() {
+	if (_scheduled || _finished)
+		return;
+
+	_scheduled = true;
+	_scheduler.schedule(*this);
+}
+
+void Session::resume() {
+	bool finished = false;
+
+	while (!finished) {
+		finished = runGame();
+
+		boost::unique_lock<boost::mutex> lock(_mutex);
+		_sendBuffer += _output;
+		_output.clear();
+		sendLocked();
+
+		if (finished) {
+			_finished = true;
+			break;
+		}
+
+		// Input, which arrived while the game was run, did not
+		// schedule the session again.
+		if (_received.empty() && !_closed) {
+			const bool hibernate = _hibernate && _game;
+			_hibernate = false;
+
+			if (!hibernate) {
+				_scheduled = false;
+				return;
+			}
+
+			// The lock is not needed for saving the game, thus
+			// the host can pass input meanwhile.
+			lock.unlock();
+			hibernateGame();
+			lock.lock();
+
+			if (_received.empty() && !_closed) {
+				_scheduled = false;
+				return;
+			}
+		}
+	}
+
+	// The host might delete the session right away.
+	_host.sessionFinished(*this);
+}
+
+bool Session::runGame() {
+	try {
+		if (!_snapshotPath.empty()) {
+			// There is no need to restore the game, when the
+			// player left anyway.
+			if (isClosed()) {
+				removeSnapshot();
+				return true;
+			}
+
+			restoreGame();
+		} else if (!_game) {
+			createGame();
+			_game->initialize();
+		}
+
+		if (!_game->resume())
+			return false;
+	} catch (const std::string &err) {
+		std::fprintf(stderr, "Session %d: %s\n", _socket, err.c_str());
+	} catch (Base::Exception &e) {
+		std::fprintf(stderr, "Session %d: %s\n", _socket, e.toString().c_str());
+	}
+
+	// This restores the player's terminal.
+	destroyGame();
+	return true;
+}
+
+void Session::createGame() {
+	_screen = new GUI::Intern::Screen(new SessionBackend(*this, _output));
+	_input = new GUI::Intern::Input(*_screen);
+	_game = new Game::GameState(_definitions, *_screen, *_input, _seed);
+}
+
+void Session::destroyGame() {
+	delete _game;
+	_game = 0;
+	delete _input;
+	_input = 0;
+	delete _screen;
+	_screen = 0;
+}
+
+void Session::hibernateGame() {
+	std::string snapshot;
+	_game->saveSnapshot(snapshot);
+
+	const std::string pattern = _host.getSnapshotDirectory() + "/hort-XXXXXX";
+	std::vector<char> path(pattern.begin(), pattern.end());
+	path.push_back(0);
+
+	const int fd = mkstemp(&path[0]);
+	if (fd < 0)
+		return;
+
+	std::string::size_type written = 0;
+	while (written < snapshot.size()) {
+		const ssize_t result = write(fd, snapshot.data() + written, snapshot.size() - written);
+		if (result < 0 && errno == EINTR)
+			continue;
+		else if (result <= 0)
+			break;
+
+		written += static_cast<std::string::size_type>(result);
+	}
+
+	if (::close(fd) != 0 || written < snapshot.size()) {
+		unlink(&path[0]);
+		return;
+	}
+
+	_snapshotPath = &path[0];
+	destroyGame();
+
+	// Destroying the game restores the player's terminal, but
+	// the game continues on the same terminal when restored.
+	_output.clear();
+}
+
+void Session::restoreGame() throw (Base::Exception) {
+	std::ifstream file(_snapshotPath.c_str(), std::ios::in | std::ios::binary);
+	std::ostringstream snapshot;
+	snapshot << file.rdbuf();
+
+	const bool readFailed = !file;
+	removeSnapshot();
+	if (readFailed)
+		throw Base::NonRecoverableException("Could not read the snapshot");
+
+	createGame();
+	_game->restoreSnapshot(snapshot.str());
+}
+
+void Session::removeSnapshot() {
+	if (_snapshotPath.empty())
+		return;
+
+	unlink(_snapshotPath.c_str());
+	_snapshotPath.clear();
+}
+
+void Session::sendOutput() {
+	boost::lock_guard<boost::mutex> lock(_mutex);
+	sendLocked();
+}
+
+void Session::sendLocked() {
+	std::string::size_type sent = 0;
+	while (sent < _sendBuffer.size()) {
+		const ssize_t result = send(_socket, _sendBuffer.data() + sent, _sendBuffer.size() - sent, MSG_NOSIGNAL);
+		if (result < 0) {
+			if (errno == EINTR)
+				continue;
+			else if (errno != EAGAIN && errno != EWOULDBLOCK)
+				_sendBuffer.clear();
+			break;
+		}
+
+		sent += static_cast<std::string::size_type>(result);
+	}
+	_sendBuffer.erase(0, sent);
+
+	if (_sendBuffer.size() > kMaxOutput) {
+		// The host notices the connection being closed and
+		// closes the session then.
+		_sendBuffer.clear();
+		shutdown(_socket, SHUT_RDWR);
+	}
+
+	const bool waitForSend = !_sendBuffer.empty();
+	if (waitForSend != _waitingForSend) {
+		_waitingForSend = waitForSend;
+		_host.waitForSend(*this, waitForSend);
+	}
+}
+
+SessionBackend::SessionBackend(Session &session, std::string &output)
+    : AnsiBackend(output, Session::kTerminalWidth, Session::kTerminalHeight), _session(session) {
+}
+
+int SessionBackend::readKey(bool wait) {
+	unsigned char input = 0;
+	if (!_session.readInput(input))
+		return (wait && _session.isClosed()) ? static_cast<int>(GUI::kKeyEscape) : static_cast<int>(GUI::Intern::kNotifyNoInput);
+
+	if (input == GUI::kKeyEscape) {
+		// The session holds an escape at the end of the input back
+		// until the rest of the sequence arrived, thus a single
+		// escape is the escape key, everything else is an escape
+		// sequence of a key we do not know about.
+		if (!_session.readInput(input))
+			return GUI::kKeyEscape;
+
+		if (input == '[' || input == 'O') {
+			do {
+				if (!_session.readInput(input))
+					break;
+			} while (input < 0x40 || input > 0x7E);
+		}
+
+		return GUI::Intern::kNotifyError;
+	} else if (input == 127 || input == '\b') {
+		return GUI::kKeyBackspace;
+	}
+
+	return input;
+}
+
+} // end of namespace Server
+
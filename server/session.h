@@ -0,0 +1,327 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef SERVER_SESSION_H
+#define SERVER_SESSION_H
+
+#include "gui/intern/ansibackend.h"
+#include "gui/intern/screen.h"
+#include "gui/intern/input.h"
+
+#include "game/game.h"
+#include "game/definitions.h"
+
+#include "base/exception.h"
+
+#include <deque>
+#include <string>
+
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace Server {
+
+class Host;
+class Scheduler;
+
+/**
+ * The game of a player connected to the host.
+ *
+ * The host reads the player's input from the connection and
+ * passes it to the session, which is scheduled then. Once run,
+ * the game processes all input and stops, when it needs more.
+ * The output is sent by the thread running the session, what
+ * does not fit into the connection is sent by the host later.
+ *
+ * When the player is idle for long, the host lets the session
+ * hibernate. The game is saved to a snapshot file and freed then,
+ * it is restored once the player enters anything.
+ */
+class Session {
+public:
+	enum {
+		/**
+		 * Up to how many bytes of input are buffered, everything
+		 * beyond is dropped.
+		 */
+		kMaxInput = 4096,
+
+		/**
+		 * Up to how many bytes of output are buffered. When a
+		 * player does not read the output, the connection is
+		 * closed.
+		 */
+		kMaxOutput = 1 << 20,
+
+		/**
+		 * How long an escape at the end of the input is held back
+		 * in microseconds. The rest of an escape sequence split
+		 * across two reads arrives within that time.
+		 */
+		kEscapeDelay = 50000,
+
+		/**
+		 * The size of the player's terminal.
+		 */
+		kTerminalWidth = 80,
+		kTerminalHeight = 24
+	};
+
+	/**
+	 * Creates a session for a connection.
+	 *
+	 * @param host Host of the session.
+	 * @param scheduler Scheduler to run the session.
+	 * @param socket Socket of the connection (non-blocking).
+	 * @param defs Definitions of the game.
+	 * @param seed Seed for the game.
+	 */
+	Session(Host &host, Scheduler &scheduler, int socket, boost::shared_ptr<const Game::Definitions> defs, uint32_t seed);
+	~Session();
+
+	/**
+	 * Returns the socket of the connection.
+	 *
+	 * @return socket.
+	 */
+	int getSocket() const { return _socket; }
+
+	/**
+	 * Starts the game.
+	 */
+	void start();
+
+	/**
+	 * Adds input read from the connection.
+	 *
+	 * An escape at the end of the input is held back, until more
+	 * input arrives or it is released.
+	 *
+	 * @param data Input data.
+	 * @param length Length of the data.
+	 * @see releaseEscape
+	 */
+	void addInput(const unsigned char *data, unsigned int length);
+
+	/**
+	 * Passes an escape held back to the game, once it is held
+	 * for kEscapeDelay. This is only called by the host's thread.
+	 *
+	 * @param now Current time in microseconds.
+	 * @return true, when an escape is still held back, false otherwise.
+	 */
+	bool releaseEscape(uint64_t now);
+
+	/**
+	 * Checks whether an escape is held back. This is only called
+	 * by the host's thread.
+	 *
+	 * @return true when held back, false otherwise.
+	 */
+	bool isHoldingEscape() const { return _escapeHeld; }
+
+	/**
+	 * Tells the session the connection was closed. The game
+	 * quits as soon as all input was processed.
+	 */
+	void close();
+
+	/**
+	 * Lets the session save its game to a snapshot file and
+	 * free it, unless there is input to process. This only has
+	 * an effect once until the player enters anything again.
+	 */
+	void hibernate();
+
+	/**
+	 * Returns when the player entered anything last. This is
+	 * only accessed by the host's thread.
+	 *
+	 * @return time in microseconds.
+	 * @see Base::Timer::getTime
+	 */
+	uint64_t getLastInputTime() const { return _lastInputTime; }
+
+	/**
+	 * Reads a byte of input, without waiting.
+	 *
+	 * @param input Where to store the byte.
+	 * @return true on success, false when there is no input.
+	 */
+	bool readInput(unsigned char &input);
+
+	/**
+	 * Checks whether the connection was closed.
+	 *
+	 * @return true when closed, false otherwise.
+	 */
+	bool isClosed();
+
+	/**
+	 * Runs the game, until it needs more input or finished.
+	 *
+	 * This is called by the scheduler only.
+	 */
+	void resume();
+
+	/**
+	 * Sends as much of the buffered output as fits into the
+	 * connection.
+	 *
+	 * This is called by the host, when the connection is ready.
+	 */
+	void sendOutput();
+private:
+	Session(const Session &);
+	Session &operator=(const Session &);
+
+	Host &_host;
+	Scheduler &_scheduler;
+	const int _socket;
+	const boost::shared_ptr<const Game::Definitions> _definitions;
+	const uint32_t _seed;
+
+	/**
+	 * The game. This is only accessed by the thread running
+	 * the session.
+	 */
+	GUI::Intern::Screen *_screen;
+	GUI::Intern::Input *_input;
+	Game::GameState *_game;
+	std::string _output;
+
+	/**
+	 * The snapshot file of the game, while the session hibernates.
+	 */
+	std::string _snapshotPath;
+
+	/**
+	 * Runs the game.
+	 *
+	 * @return true, when the game finished, false when it waits for input.
+	 */
+	bool runGame();
+	void createGame();
+	void destroyGame();
+
+	/**
+	 * Saves the game to a snapshot file and frees it. When
+	 * the file can not be written, the game is kept.
+	 */
+	void hibernateGame();
+
+	/**
+	 * Restores the game from the snapshot file.
+	 */
+	void restoreGame() throw (Base::Exception);
+
+	/**
+	 * Removes the snapshot file (if any).
+	 */
+	void removeSnapshot();
+
+	/**
+	 * When the player entered anything last and whether the
+	 * session was asked to hibernate since then. These are only
+	 * accessed by the host's thread.
+	 */
+	uint64_t _lastInputTime;
+	bool _idle;
+
+	/**
+	 * Whether an escape at the end of the input is held back and
+	 * since when. These are only accessed by the host's thread.
+	 */
+	bool _escapeHeld;
+	uint64_t _escapeTime;
+
+	boost::mutex _mutex;
+	std::deque<unsigned char> _received;
+	std::string _sendBuffer;
+	bool _closed;
+	bool _scheduled;
+	bool _finished;
+
+	/**
+	 * Whether the session should hibernate, once all input
+	 * is processed.
+	 */
+	bool _hibernate;
+
+	/**
+	 * Whether the host waits for the connection to get ready
+	 * for more output.
+	 */
+	bool _waitingForSend;
+
+	/**
+	 * Schedules the session, unless it is scheduled or finished
+	 * already. The mutex must be locked.
+	 */
+	void scheduleLocked();
+
+	/**
+	 * Adds input to the received input. The mutex must be locked.
+	 */
+	void receiveLocked(const unsigned char *data, unsigned int length);
+
+	/**
+	 * Sends the buffered output. The mutex must be locked.
+	 */
+	void sendLocked();
+};
+
+/**
+ * A backend, which outputs to the connection of a session
+ * and takes its input from the session.
+ *
+ * Once the connection is closed, the escape key is returned,
+ * when the game waits for input, so the game always ends.
+ */
+class SessionBackend : public GUI::Intern::AnsiBackend {
+public:
+	/**
+	 * @param session Session to take the input from.
+	 * @param output String to append the output to.
+	 */
+	SessionBackend(Session &session, std::string &output);
+
+	// The game of a session is only run, when there is input,
+	// thus it never waits for it.
+	int poll() { return readKey(true); }
+	int pollPending() { return readKey(false); }
+private:
+	Session &_session;
+
+	/**
+	 * Reads a key from the session.
+	 *
+	 * @param wait Whether the game waits for the key.
+	 * @return key, kNotifyNoInput when there is no input.
+	 */
+	int readKey(bool wait);
+};
+
+} // end of namespace Server
+
+#endif
+
@@ -0,0 +1,237 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "policy.h"
+
+#include "gui/intern/screen.h"
+#include "gui/intern/input.h"
+
+#include "game/state.h"
+#include "game/game.h"
+#include "game/definitions.h"
+
+#include "base/threadpool.h"
+#include "base/timer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/ref.hpp>
+
+namespace {
+
+/**
+ * A game of the batch.
+ */
+struct SimulatedGame {
+	/**
+	 * Seed of the game.
+	 */
+	uint32_t _seed;
+
+	/**
+	 * The outcome of the game.
+	 */
+	Game::GameStatistics _stats;
+
+	/**
+	 * The error, which aborted the game (empty when the
+	 * game finished).
+	 */
+	std::string _error;
+
+	explicit SimulatedGame(uint32_t seed) : _seed(seed), _stats(), _error() {}
+};
+
+/**
+ * Runs a single game.
+ *
+ * Everything but the definitions is created for every game on
+ * its own, so the games do not share any mutable state.
+ */
+void runGame(boost::shared_ptr<const Game::Definitions> defs, const std::string &script, unsigned int maxKeys, SimulatedGame &game) {
+	Sim::Policy *policy;
+	if (script.empty())
+		// The policy must not roll the same numbers as the game.
+		policy = new Sim::RandomPolicy(~game._seed);
+	else
+		policy = new Sim::ScriptPolicy(script);
+
+	try {
+		GUI::Intern::Screen screen(new Sim::PolicyBackend(policy, maxKeys));
+		GUI::Intern::Input input(screen);
+
+		Game::StateHandler states;
+		states.addStateToQueue(new Game::GameState(defs, screen, input, game._seed, 0, 0, 0, &game._stats));
+		states.process();
+	} catch (const std::string &err) {
+		game._error = err;
+	} catch (Base::Exception &e) {
+		game._error = e.toString();
+	}
+}
+
+/**
+ * Parses the value of a numeric option.
+ */
+bool parseValue(const char *value, unsigned int &result) {
+	try {
+		result = boost::lexical_cast<unsigned int>(value);
+		return true;
+	} catch (boost::bad_lexical_cast &) {
+		std::fprintf(stderr, "ERROR: Invalid number \"%s\"\n", value);
+		return false;
+	}
+}
+
+/**
+ * Prints the count of every monster type, which has any.
+ */
+void printMonsterCounts(const Game::MonsterDatabase &monsters, const std::vector<unsigned int> &counts) {
+	for (Game::MonsterType type = 0; type < counts.size(); ++type) {
+		if (counts[type])
+			std::printf("  %-20s %u\n", monsters.getMonsterName(type), counts[type]);
+	}
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char **argv) {
+	unsigned int games = 1000;
+	unsigned int threads = 0;
+	unsigned int seed = static_cast<unsigned int>(std::time(0));
+	unsigned int maxKeys = 10000;
+	std::string script;
+
+	for (int i = 1; i < argc; ++i) {
+		bool valid = true;
+
+		if (!std::strncmp(argv[i], "--games=", 8)) {
+			valid = parseValue(argv[i] + 8, games);
+		} else if (!std::strncmp(argv[i], "--threads=", 10)) {
+			valid = parseValue(argv[i] + 10, threads);
+		} else if (!std::strncmp(argv[i], "--seed=", 7)) {
+			valid = parseValue(argv[i] + 7, seed);
+		} else if (!std::strncmp(argv[i], "--keys=", 7)) {
+			valid = parseValue(argv[i] + 7, maxKeys);
+		} else if (!std::strncmp(argv[i], "--script=", 9) && argv[i][9]) {
+			script = argv[i] + 9;
+		} else {
+			std::fprintf(stderr, "Usage: %s [--games=N] [--threads=N] [--seed=N] [--keys=N] [--script=KEYS]\n\n", argv[0]);
+			std::fprintf(stderr, "Runs N headless games, the i-th game uses the given seed + i.\n");
+			std::fprintf(stderr, "With --threads=0 (the default) one thread per core is used.\n");
+			std::fprintf(stderr, "With --keys the player quits after entering that many keys.\n");
+			std::fprintf(stderr, "With --script the player enters the given keys over and over again,\n");
+			std::fprintf(stderr, "otherwise he walks around randomly.\n");
+			return -1;
+		}
+
+		if (!valid)
+			return -1;
+	}
+
+	boost::shared_ptr<Game::Definitions> loadedDefs(new Game::Definitions());
+	try {
+		loadedDefs->load("./data");
+	} catch (Base::NonRecoverableException &e) {
+		std::fprintf(stderr, "%s\n", e.toString().c_str());
+		return -1;
+	}
+
+	const boost::shared_ptr<const Game::Definitions> defs = loadedDefs;
+
+	// The results are stored in a slot per game, thus the threads
+	// never need to synchronize on them.
+	std::vector<SimulatedGame> results;
+	results.reserve(games);
+	for (unsigned int i = 0; i < games; ++i)
+		results.push_back(SimulatedGame(seed + i));
+
+	Base::ThreadPool pool(threads);
+	for (unsigned int i = 0; i < games; ++i)
+		pool.addTask(boost::bind(&runGame, defs, boost::cref(script), maxKeys, boost::ref(results[i])));
+
+	Base::Timer timer;
+	pool.run();
+	const double seconds = static_cast<double>(timer.getElapsed()) / 1000000.0;
+
+	const Game::MonsterDatabase &monsters = defs->getMonsterDatabase();
+	std::vector<unsigned int> killers(monsters.getMonsterTypeCount()), kills(monsters.getMonsterTypeCount());
+	unsigned int failed = 0, killed = 0, drowned = 0, totalKills = 0;
+	unsigned int minTurns = ~0u, maxTurns = 0;
+	uint64_t totalTurns = 0;
+
+	for (std::vector<SimulatedGame>::const_iterator i = results.begin(); i != results.end(); ++i) {
+		if (!i->_error.empty()) {
+			if (!failed++)
+				std::fprintf(stderr, "Game with seed %u failed: %s\n", i->_seed, i->_error.c_str());
+			continue;
+		}
+
+		const Game::GameStatistics &stats = i->_stats;
+		totalTurns += stats._turns;
+		minTurns = std::min(minTurns, stats._turns);
+		maxTurns = std::max(maxTurns, stats._turns);
+
+		if (stats._died) {
+			if (stats._deathCause == Game::DeathEvent::kDrowned) {
+				++drowned;
+			} else {
+				++killed;
+				++killers[stats._killer];
+			}
+		}
+
+		for (Game::MonsterType type = 0; type < stats._kills.size(); ++type) {
+			kills[type] += stats._kills[type];
+			totalKills += stats._kills[type];
+		}
+	}
+
+	const unsigned int finished = games - failed;
+	std::printf("Games: %u in %.3f s on %u threads (%.1f games per second)\n", games, seconds, pool.getThreadCount(),
+	            seconds > 0 ? games / seconds : 0.0);
+	if (failed)
+		std::printf("Failed: %u\n", failed);
+	if (!finished)
+		return -1;
+
+	std::printf("Turns: %.1f on average, %u at least, %u at most\n",
+	            static_cast<double>(totalTurns) / finished, minTurns, maxTurns);
+	std::printf("Deaths: %u killed, %u drowned, %u survived\n", killed, drowned, finished - killed - drowned);
+	if (killed) {
+		std::printf("Killed by:\n");
+		printMonsterCounts(monsters, killers);
+	}
+	if (totalKills) {
+		std::printf("Kills:\n");
+		printMonsterCounts(monsters, kills);
+	}
+
+	return failed ? -1 : 0;
+}
+
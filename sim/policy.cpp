@@ -0,0 +1,83 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "policy.h"
+
+#include "gui/defs.h"
+#include "gui/intern/input.h"
+
+#include <cassert>
+
+namespace Sim {
+
+namespace {
+const char kDirectionKeys[] = "hjklyubn";
+} // end of anonymous namespace
+
+RandomPolicy::RandomPolicy(uint32_t seed) : _rng(seed), _key(0), _repeats(0) {
+}
+
+int RandomPolicy::nextKey() {
+	if (!_repeats) {
+		if (_rng.rollDice(5) == 5)
+			_key = '.';
+		else
+			_key = kDirectionKeys[_rng.rollDice(sizeof(kDirectionKeys) - 1) - 1];
+
+		_repeats = _rng.rollDice(8);
+	}
+
+	--_repeats;
+	return _key;
+}
+
+ScriptPolicy::ScriptPolicy(const std::string &keys) : _keys(keys), _next(0) {
+	assert(!_keys.empty());
+}
+
+int ScriptPolicy::nextKey() {
+	const int key = static_cast<unsigned char>(_keys[_next]);
+	_next = (_next + 1) % _keys.size();
+	return key;
+}
+
+PolicyBackend::PolicyBackend(Policy *policy, unsigned int maxKeys) : NullBackend(), _policy(policy), _keysLeft(maxKeys) {
+}
+
+PolicyBackend::~PolicyBackend() {
+	delete _policy;
+}
+
+int PolicyBackend::poll() {
+	if (!_keysLeft)
+		return GUI::kKeyEscape;
+
+	--_keysLeft;
+	return _policy->nextKey();
+}
+
+int PolicyBackend::pollPending() {
+	if (!_keysLeft)
+		return GUI::Intern::kNotifyNoInput;
+	return poll();
+}
+
+} // end of namespace Sim
+
@@ -0,0 +1,115 @@
+/* Hort - A roguelike inspired by the Nibelungenlied
+ *
+ * (c) 2009-2010 by Johannes Schickel <lordhoto at scummvm dot org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef SIM_POLICY_H
+#define SIM_POLICY_H
+
+#include "gui/intern/headlessbackend.h"
+
+#include "base/rnd.h"
+
+#include <string>
+
+#include <stdint.h>
+
+namespace Sim {
+
+/**
+ * A policy, which plays a game instead of a player, by
+ * entering his keys.
+ */
+class Policy {
+public:
+	virtual ~Policy() {}
+
+	/**
+	 * Returns the next key the player enters.
+	 *
+	 * @return key.
+	 */
+	virtual int nextKey() = 0;
+};
+
+/**
+ * A policy, which walks around randomly.
+ *
+ * It keeps walking into a random direction for a few steps,
+ * sometimes it waits instead.
+ */
+class RandomPolicy : public Policy {
+public:
+	/**
+	 * @param seed Seed for the random decisions.
+	 */
+	explicit RandomPolicy(uint32_t seed);
+
+	int nextKey();
+private:
+	Base::RNG _rng;
+
+	int _key;
+	unsigned int _repeats;
+};
+
+/**
+ * A policy, which enters a fixed script of keys over and
+ * over again.
+ */
+class ScriptPolicy : public Policy {
+public:
+	/**
+	 * @param keys Keys of the script (may not be empty).
+	 */
+	explicit ScriptPolicy(const std::string &keys);
+
+	int nextKey();
+private:
+	const std::string _keys;
+	std::string::size_type _next;
+};
+
+/**
+ * A headless backend, which takes its input from a policy.
+ *
+ * After the given number of keys the escape key is returned,
+ * so a game run with this backend always ends.
+ */
+class PolicyBackend : public GUI::Intern::NullBackend {
+public:
+	/**
+	 * The backend takes over the ownership of the policy.
+	 *
+	 * @param policy Policy to enter the keys.
+	 * @param maxKeys Number of keys to take from the policy.
+	 */
+	PolicyBackend(Policy *policy, unsigned int maxKeys);
+	~PolicyBackend();
+
+	int poll();
+	int pollPending();
+private:
+	Policy *_policy;
+	unsigned int _keysLeft;
+};
+
+} // end of namespace Sim
+
+#endif
+